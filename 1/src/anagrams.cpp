@@ -1,144 +1,572 @@
-#include <fstream>
 #include <algorithm>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "anagrams.hpp"
 
 using namespace std;
 
 /**
- * Remove from a string undesired characters such as spaces, figures, etc. and replace uppercases by corresponding lowercases.
+ * Words of a dictionary that are subsets of a histogram, in search order.
  *
- * @param[in,out] str a string to clean up.
+ * @note the histograms are copied contiguously, with the counter type of the search, such that the search scans them without indirection nor conversion.
  */
-static void cleanUp(string& str) {
-    for (auto it = str.begin(); it != str.end();)
-        if (islower(*it))
-            ++it;
-        else if (isupper(*it))
-            *(it++) += 'a' - 'A';
-        else
-            it = str.erase(it);
+template <typename T>
+struct Candidates {
+    vector<Histogram<LANES, T>> histograms;
+    vector<uint32_t> indices;
+};
+
+/**
+ * Collect the words of a dictionary that are subsets of a histogram.
+ *
+ * @param[in] astr a histogram.
+ * @param[in] dict the used dictionary.
+ * @return the candidates, in reverse dictionary order.
+ */
+template <typename T>
+static Candidates<T> filter(const Histogram<LANES, T>& astr, const Dictionary& dict) {
+    Candidates<T> candidates;
+    const vector<astring>& histograms = dict.histogram();
+
+    for (uint32_t i = histograms.size(); i-- > 0;)
+        if (isSub(astr, histograms[i])) {
+            candidates.histograms.push_back(convert<T>(histograms[i]));
+            candidates.indices.push_back(i);
+        }
+
+    return candidates;
 }
 
-typedef std::array<short, 27> astring;
+/**
+ * @return the positions of all candidates.
+ */
+template <typename T>
+static vector<uint32_t> positions(const Candidates<T>& candidates) {
+    vector<uint32_t> positions(candidates.indices.size());
+    for (uint32_t i = 0; i < positions.size(); ++i)
+        positions[i] = i;
+
+    return positions;
+}
 
 /**
- * Transform a string into an astring.
+ * Subproblem of the anagram search : the anagrams of a residual histogram using only the candidates up to a position.
  *
- * @note the string should have a to z characters only.
+ * @note a candidate at a given position only combines with the candidates at previous positions which are subsets of the residual. Thus, the anagrams of a subproblem only depend on the residual, the position and max.
+ */
+template <typename T>
+struct Subproblem {
+    Histogram<LANES, T> astr;
+    uint32_t position;
+    int max;
+
+    bool operator ==(const Subproblem& sub) const { return position == sub.position && max == sub.max && astr == sub.astr; }
+};
+
+template <typename T>
+struct SubproblemHash {
+    size_t operator ()(const Subproblem<T>& sub) const {
+        size_t h = sub.position * 31 + sub.max;
+        for (T n : sub.astr)
+            h = h * 131 + n;
+
+        return h;
+    }
+};
+
+/**
+ * Minimum number of residual letters for a subproblem to be memoized.
+ */
+static const unsigned MEMO_MIN = 6;
+
+/**
+ * Maximum number of completions stored for a cached subproblem.
+ */
+static const size_t CACHE_MAX = 64;
+
+/**
+ * Completions of the already-explored subproblems. An empty container marks a dead end.
+ */
+template <typename T>
+using Cache = unordered_map<Subproblem<T>, vector<vector<uint32_t>>, SubproblemHash<T>>;
+
+/**
+ * Completions of a subproblem being explored.
+ */
+struct Recorder {
+    size_t depth;
+    vector<vector<uint32_t>> suffixes;
+    bool overflow;
+};
+
+/**
+ * State of an anagram search.
+ */
+template <typename T>
+struct Search {
+    const Candidates<T>& candidates;
+    const Visitor& visit;
+    vector<uint32_t> wrds;
+    size_t count;
+    Cache<T>& cache;
+    vector<Recorder> recorders;
+    size_t lookups, hits;
+};
+
+/**
+ * Hand the current anagram to the visitor and to the recorders of the subproblems it completes.
  *
- * @param str a string.
- * @return the transformed string.
+ * @param[in,out] search the search state.
  */
-static astring atransform(string str) {
-    astring astr = {(short) str.length()};
-    for (char c : str)
-        ++astr[c - 'a' + 1];
+template <typename T>
+static void emit(Search<T>& search) {
+    search.visit(search.wrds);
+    ++search.count;
 
-    return astr;
+    for (Recorder& rec : search.recorders)
+        if (rec.overflow)
+            continue;
+        else if (rec.suffixes.size() == CACHE_MAX) {
+            rec.overflow = true;
+            rec.suffixes.clear();
+        } else
+            rec.suffixes.emplace_back(search.wrds.begin() + rec.depth, search.wrds.end());
 }
 
 /**
- * Search if an astring is a subset of another.
+ * Compute all anagrams of a histogram, recursively.
+ *
+ * @note subproblems with enough residual letters are cached : a dead end is pruned instantly and a small subproblem is replayed from its stored completions.
  *
- * @param[in] astr an astring.
- * @param[in] asub a supposed subset.
- * @return true if asub is a subset of astr, false otherwise.
+ * @param[in] astr the histogram whose anagrams are searched.
+ * @param[in] positions the positions of the candidates in which it is still useful to search anagrams.
+ * @param[in,out] search the search state. In spite of manipulations, search.wrds returns to its initial state after execution.
+ * @param[in] max the maximum number of words that are allowed to be added to current. If max is negative, there is no limit.
  */
-static bool isSub(const astring& astr, const astring& asub) {
-    for (unsigned i = 0; i < 27; ++i)
-        if (astr[i] < asub[i])
-            return false;
+template <typename T>
+static void build(const Histogram<LANES, T>& astr, const vector<uint32_t>& positions, Search<T>& search, int max) {
+    if (max == 0)
+        return;
+
+    // Without a limit, the subproblems of every depth share their cache entries
+    int rest = max < 0 ? -1 : max - 1;
+
+    Histogram<LANES, T> ares;
+    vector<uint32_t> newpositions;
+
+    for (auto it = positions.begin(); it != positions.end(); ++it)
+        if (isRes(astr, search.candidates.histograms[*it], ares)) {
+            newpositions.push_back(*it);
+            search.wrds.push_back(search.candidates.indices[*it]);
+
+            if (ares[0] == 0)
+                emit(search);
+            else if (ares[0] < MEMO_MIN)
+                build(ares, newpositions, search, rest);
+            else {
+                Subproblem<T> sub = {ares, *it, rest};
+                auto found = search.cache.find(sub);
+
+                ++search.lookups;
+
+                if (found != search.cache.end()) {
+                    ++search.hits;
+
+                    size_t depth = search.wrds.size();
+                    for (auto& suffix : found->second) {
+                        search.wrds.insert(search.wrds.end(), suffix.begin(), suffix.end());
+                        emit(search);
+                        search.wrds.resize(depth);
+                    }
+                } else {
+                    search.recorders.push_back({search.wrds.size(), {}, false});
+                    build(ares, newpositions, search, rest);
+
+                    Recorder rec = move(search.recorders.back());
+                    search.recorders.pop_back();
+
+                    if (!rec.overflow)
+                        search.cache.emplace(sub, move(rec.suffixes));
+                }
+            }
+
+            search.wrds.pop_back();
+        }
+}
+
+/**
+ * Generate all anagrams of a histogram, with the counter type of the search.
+ */
+template <typename T>
+static size_t anagrams(const Histogram<LANES, T>& astr, const Dictionary& dict, unsigned max, const Visitor& visit, CacheStatistics* stats) {
+    Candidates<T> candidates = filter(astr, dict);
+    Cache<T> cache;
+    Search<T> search = {candidates, visit, {}, 0, cache, {}, 0, 0};
+
+    build(astr, positions(candidates), search, max == 0 ? -1 : max);
+
+    if (stats != nullptr)
+        *stats = {search.cache.size(), search.lookups, search.hits};
+
+    return search.count;
+}
+
+size_t anagrams(const string& input, const Dictionary& dict, unsigned max, const Visitor& visit, CacheStatistics* stats) {
+    Histogram<LANES, uint16_t> astr = histogram<uint16_t>(input, dict.alphabet());
+
+    // Byte counters fit most inputs and halve the work of each comparison
+    if (astr[0] <= UINT8_MAX)
+        return anagrams(convert<uint8_t>(astr), dict, max, visit, stats);
+
+    return anagrams(astr, dict, max, visit, stats);
+}
+
+vector<vector<string>> anagrams(const string& input, const Dictionary& dict, unsigned max) {
+    vector<vector<string>> anagrams;
+
+    ::anagrams(input, dict, max, [&](const vector<uint32_t>& wrds) {
+        anagrams.emplace_back();
+        for (uint32_t i : wrds)
+            anagrams.back().push_back(dict.word(i));
+    });
+
+    return anagrams;
+}
+
+/**
+ * Candidates and subproblem cache of a query, shared by all its refinements with the same letters.
+ */
+struct Query::State {
+    Candidates<uint8_t> candidates;
+    vector<uint32_t> positions;
+    Cache<uint8_t> cache;
+    unordered_map<string, uint32_t> words;
+    size_t lookups, hits;
+};
+
+Query::Query(const string& input, const Dictionary& dict, unsigned max) : dict(dict), astr(histogram<uint16_t>(input, dict.alphabet())), max(max) {}
+
+Query::~Query() {}
+
+size_t Query::anagrams(const vector<string>& wrds, const string& letters, const Visitor& visit, CacheStatistics* stats) {
+    Histogram<LANES, uint16_t> extra = histogram<uint16_t>(letters, dict.alphabet()), atotal = astr;
+    for (size_t i = 0; i < LANES; ++i)
+        atotal[i] += extra[i];
+
+    if (atotal[0] > UINT8_MAX)
+        return 0;
 
-    return true;
+    unique_ptr<State>& state = states[extra];
+
+    if (!state) {
+        state.reset(new State());
+        state->candidates = filter(convert<uint8_t>(atotal), dict);
+        state->positions = positions(state->candidates);
+        state->lookups = state->hits = 0;
+
+        for (uint32_t i : state->candidates.indices)
+            state->words.emplace(dict.word(i), i);
+    }
+
+    Search<uint8_t> search = {state->candidates, visit, {}, 0, state->cache, {}, 0, 0};
+
+    // Remove the required words from the letters
+    astring ares = convert<uint8_t>(atotal);
+
+    for (const string& wrd : wrds) {
+        auto it = state->words.find(wrd);
+
+        if (it == state->words.end() || !isRes(ares, dict.histogram(it->second), ares))
+            return 0;
+
+        search.wrds.push_back(it->second);
+    }
+
+    if (max > 0 && wrds.size() > max)
+        return 0;
+
+    if (ares[0] == 0) {
+        if (!wrds.empty())
+            emit(search);
+    } else
+        build(ares, state->positions, search, max == 0 ? -1 : max - wrds.size());
+
+    state->lookups += search.lookups;
+    state->hits += search.hits;
+
+    if (stats != nullptr)
+        *stats = {state->cache.size(), state->lookups, state->hits};
+
+    return search.count;
 }
 
 /**
- * Search if an astring is a subset of another and compute the residual if so.
+ * Count all anagrams of a histogram, recursively.
+ *
+ * @note the count of a subproblem is memoized.
  *
- * @param[in] astr an astring.
- * @param[in] asub a supposed subset.
- * @param[out] ares the residual.
- * @return true if asub is a subset of astr, false otherwise.
+ * @param[in] astr the histogram whose anagrams are counted.
+ * @param[in] positions the positions of the candidates in which it is still useful to search anagrams.
+ * @param[in] candidates the words that are subsets of the initial histogram.
+ * @param[in,out] memo the already-counted subproblems.
+ * @param[in] max the maximum number of words that are allowed. If max is negative, there is no limit.
+ * @return the number of anagrams.
  */
-static bool isRes(const astring& astr, const astring& asub, astring& ares) {
-    if (astr[0] < asub[0])
-        return false;
+template <typename T>
+static size_t count(const Histogram<LANES, T>& astr, const vector<uint32_t>& positions, const Candidates<T>& candidates, unordered_map<Subproblem<T>, size_t, SubproblemHash<T>>& memo, int max) {
+    if (max == 0)
+        return 0;
+
+    // Without a limit, the subproblems of every depth share their counts
+    int rest = max < 0 ? -1 : max - 1;
+
+    size_t number = 0;
+    Histogram<LANES, T> ares;
+    vector<uint32_t> newpositions;
+
+    for (auto it = positions.begin(); it != positions.end(); ++it)
+        if (isRes(astr, candidates.histograms[*it], ares)) {
+            newpositions.push_back(*it);
+
+            if (ares[0] == 0) {
+                ++number;
+                continue;
+            }
 
-    ares = astr;
-    for (unsigned i = 1; i < 27; ++i)
-        if (asub[i] > 0 && (ares[i] -= asub[i]) < 0)
-            return false;
+            // Small residuals are cheaper to count again than to hash
+            if (ares[0] < MEMO_MIN) {
+                number += count(ares, newpositions, candidates, memo, rest);
+                continue;
+            }
 
-    ares[0] -= asub[0];
+            Subproblem<T> sub = {ares, *it, rest};
+            auto found = memo.find(sub);
 
-    return true;
+            if (found == memo.end())
+                found = memo.emplace(sub, count(ares, newpositions, candidates, memo, rest)).first;
+
+            number += found->second;
+        }
+
+    return number;
+}
+
+/**
+ * Count all anagrams of a histogram, with the counter type of the search.
+ */
+template <typename T>
+static size_t count_anagrams(const Histogram<LANES, T>& astr, const Dictionary& dict, unsigned max) {
+    Candidates<T> candidates = filter(astr, dict);
+    unordered_map<Subproblem<T>, size_t, SubproblemHash<T>> memo;
+
+    return count(astr, positions(candidates), candidates, memo, max == 0 ? -1 : max);
 }
 
-typedef Dictionary::const_iterator reference;
+size_t count_anagrams(const string& input, const Dictionary& dict, unsigned max) {
+    Histogram<LANES, uint16_t> astr = histogram<uint16_t>(input, dict.alphabet());
+
+    if (astr[0] <= UINT8_MAX)
+        return count_anagrams(convert<uint8_t>(astr), dict, max);
+
+    return count_anagrams(astr, dict, max);
+}
+
+/**
+ * Compare anagrams by their number of words.
+ */
+struct Longer {
+    bool operator ()(const vector<uint32_t>& a, const vector<uint32_t>& b) const { return a.size() < b.size(); }
+};
+
+typedef priority_queue<vector<uint32_t>, vector<vector<uint32_t>>, Longer> Selection;
 
 /**
- * Compute all anagrams of an astring, recursively.
+ * Search the anagrams of a histogram with the fewest words, recursively.
  *
- * @param[in] astr the astring whose anagrams are searched.
- * @param[in] references a container of references to words in which it is still useful to search anagrams.
- * @param[in] wrds the container of previous words in the current anagram. In spite of manipulations, wrds returns to its initial state after execution.
- * @param[in,out] anagrams the container of already-computed anagrams.
+ * @param[in] astr the histogram whose anagrams are searched.
+ * @param[in] positions the positions of the candidates in which it is still useful to search anagrams.
+ * @param[in] candidates the words that are subsets of the initial histogram.
+ * @param[in] wrds the container of indices of previous words in the current anagram. In spite of manipulations, wrds returns to its initial state after execution.
+ * @param[in,out] best the k anagrams with the fewest words found so far, the one with the most words on top.
+ * @param[in] k the number of searched anagrams.
  * @param[in] max the maximum number of words that are allowed to be added to current. If max is negative, there is no limit.
  */
-static void build(const astring& astr, const vector<reference>& references, vector<string>& wrds, vector<vector<string>>& anagrams, int max) {
+template <typename T>
+static void select(const Histogram<LANES, T>& astr, const vector<uint32_t>& positions, const Candidates<T>& candidates, vector<uint32_t>& wrds, Selection& best, size_t k, int max) {
     if (max == 0)
         return;
 
-    astring ares;
-    vector<reference> newreferences;
+    Histogram<LANES, T> ares;
+    vector<uint32_t> newpositions;
+    size_t longest = 0;
 
-    for (auto it = references.begin(); it != references.end(); ++it)
-        if (isRes(astr, (**it).second, ares)) {
-            newreferences.push_back(*it);
+    for (auto it = positions.begin(); it != positions.end(); ++it)
+        if (isRes(astr, candidates.histograms[*it], ares)) {
+            newpositions.push_back(*it);
+            longest = std::max<size_t>(longest, candidates.histograms[*it][0]);
 
-            wrds.push_back((**it).first);
-            if (ares[0] > 0)
-                build(ares, newreferences, wrds, anagrams, max - 1);
-            else
-                anagrams.push_back(wrds);
+            wrds.push_back(candidates.indices[*it]);
+            if (ares[0] == 0) {
+                if (best.size() < k)
+                    best.push(wrds);
+                else if (wrds.size() < best.top().size()) {
+                    best.pop();
+                    best.push(wrds);
+                }
+            } else {
+                // The residual needs at least ceil(ares[0] / longest) more words
+                size_t bound = wrds.size() + (ares[0] + longest - 1) / longest;
+
+                if (best.size() < k || bound < best.top().size())
+                    select(ares, newpositions, candidates, wrds, best, k, max - 1);
+            }
             wrds.pop_back();
         }
 }
 
-vector<vector<string>> anagrams(const string& input, const Dictionary& dict, unsigned max) {
-    vector<reference> references;
-    vector<vector<string>> anagrams;
-    vector<string> wrds;
+/**
+ * Search the anagrams of a histogram with the fewest words, with the counter type of the search.
+ */
+template <typename T>
+static void select(const Histogram<LANES, T>& astr, const Dictionary& dict, Selection& best, size_t k, unsigned max) {
+    vector<uint32_t> wrds;
+    Candidates<T> candidates = filter(astr, dict);
+
+    select(astr, positions(candidates), candidates, wrds, best, k, max == 0 ? -1 : max);
+}
 
-    string str = input;
-    cleanUp(str);
-    astring astr = atransform(str);
+vector<vector<string>> shortest_anagrams(const string& input, const Dictionary& dict, unsigned max, size_t k) {
+    Selection best;
 
-    for (auto it = dict.begin(); it != dict.end(); ++it)
-        if (isSub(astr, (*it).second))
-            references.push_back(it);
-    reverse(references.begin(), references.end());
+    Histogram<LANES, uint16_t> astr = histogram<uint16_t>(input, dict.alphabet());
+
+    if (k > 0) {
+        if (astr[0] <= UINT8_MAX)
+            select(convert<uint8_t>(astr), dict, best, k, max);
+        else
+            select(astr, dict, best, k, max);
+    }
 
-    build(astr, references, wrds, anagrams, max == 0 ? -1 : max);
+    vector<vector<string>> anagrams(best.size());
+    for (auto it = anagrams.rbegin(); it != anagrams.rend(); ++it, best.pop())
+        for (uint32_t i : best.top())
+            it->push_back(dict.word(i));
 
     return anagrams;
 }
 
-Dictionary create_dictionary(const string& filename) {
-    Dictionary dict;
+/**
+ * Minimum number of bytes of a word list chunk loaded by a thread.
+ */
+static const size_t CHUNK_MIN = 1 << 16;
+
+/**
+ * Load the words of a word list chunk.
+ *
+ * @note words are separated by whitespaces, cleaned up and transformed in a single pass. Words with a letter outside the alphabet are skipped.
+ *
+ * @param[in] begin the first character of the chunk.
+ * @param[in] end the character past the last of the chunk.
+ * @param[out] dict the dictionary receiving the words.
+ */
+static void load(const char* begin, const char* end, Dictionary& dict) {
+    // Lane of each character, 0 for ignored characters, -1 for separators and -2 for letters outside the alphabet
+    array<int, 256> lanes;
+
+    for (int c = 0; c < 256; ++c)
+        if (isspace(c))
+            lanes[c] = -1;
+        else if (uint8_t l = dict.alphabet().lane(c))
+            lanes[c] = l;
+        else
+            lanes[c] = isalpha(c) ? -2 : 0;
+
     string wrd;
-    ifstream file;
+    astring astr;
+
+    dict.reserve(count(begin, end, '\n') + 1, end - begin);
+
+    for (const char* it = begin; it != end;) {
+        while (it != end && lanes[(unsigned char) *it] == -1)
+            ++it;
 
-    file.open(filename);
+        wrd.clear();
+        astr.fill(0);
+        bool foreign = false;
 
-    while (file >> wrd) {
-        cleanUp(wrd);
-        if (!wrd.empty())
-            dict.push_back(pair<string, astring>(wrd, atransform(wrd)));
+        for (int l; it != end && (l = lanes[(unsigned char) *it]) != -1; ++it)
+            if (l > 0) {
+                wrd.push_back(dict.alphabet().letter(l));
+                ++astr[l];
+            } else
+                foreign |= l < 0;
+
+        if (!foreign && !wrd.empty() && wrd.length() <= UINT8_MAX) {
+            astr[0] = wrd.length();
+            dict.push_back(wrd, astr);
+        }
+    }
+}
+
+Dictionary create_dictionary(const string& filename, const Alphabet& alphabet) {
+    Dictionary dict(alphabet);
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return dict;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return dict;
     }
 
-    file.close();
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return dict;
+
+    const char* data = static_cast<const char*>(map);
+
+    // Split the file in chunks on newline boundaries
+    size_t n = max<size_t>(min<size_t>(thread::hardware_concurrency(), size / CHUNK_MIN), 1);
+    vector<const char*> bounds = {data};
+
+    for (size_t i = 1; i < n; ++i) {
+        const char* it = max(data + size * i / n, bounds.back());
+        while (it != data + size && *it != '\n')
+            ++it;
+
+        bounds.push_back(it);
+    }
+    bounds.push_back(data + size);
+
+    // Load the chunks in parallel and concatenate them in order
+    vector<Dictionary> parts(n, dict);
+    vector<thread> pool;
+
+    for (size_t i = 1; i < n; ++i)
+        pool.emplace_back(load, bounds[i], bounds[i + 1], ref(parts[i]));
+    load(bounds[0], bounds[1], parts[0]);
+
+    for (auto& t : pool)
+        t.join();
+
+    munmap(map, size);
+
+    dict = move(parts[0]);
+    for (size_t i = 1; i < n; ++i)
+        dict.append(parts[i]);
 
     return dict;
 }
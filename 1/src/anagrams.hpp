@@ -2,11 +2,108 @@
 #define ANAGRAMS
 
 #include <string>
-#include <utility> /// std::pair
 #include <vector>
 #include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 
-typedef std::vector<std::pair<std::string, std::array<short, 27>>> Dictionary;
+#include "histogram.hpp"
+
+/**
+ * Letter histogram of a word.
+ *
+ * @note words have at most 255 letters, such that their counters are single bytes.
+ */
+typedef Histogram<LANES, uint8_t> astring;
+
+/**
+ * Container of words, indexed by uint32_t.
+ *
+ * @note words are pooled, null-terminated, in a single string and their histograms are stored in a separate contiguous container.
+ */
+class Dictionary {
+    public:
+        /**
+         * @param alphabet the alphabet of the words.
+         */
+        Dictionary(const Alphabet& alphabet = Alphabet()) : letters(alphabet) {}
+
+        /**
+         * @return the alphabet of the words.
+         */
+        const Alphabet& alphabet() const { return letters; }
+
+        /**
+         * @return the number of words.
+         */
+        size_t size() const { return offsets.size(); }
+
+        bool empty() const { return offsets.empty(); }
+
+        /**
+         * @return the ith word.
+         */
+        const char* word(uint32_t i) const { return pool.data() + offsets[i]; }
+
+        /**
+         * @return the length of the ith word.
+         */
+        size_t length(uint32_t i) const { return histograms[i][0]; }
+
+        /**
+         * @return the histogram of the ith word.
+         */
+        const astring& histogram(uint32_t i) const { return histograms[i]; }
+
+        /**
+         * @return the histograms of all words.
+         */
+        const std::vector<astring>& histogram() const { return histograms; }
+
+        /**
+         * Reserve storage for a number of words and of characters.
+         */
+        void reserve(size_t words, size_t characters) {
+            pool.reserve(characters + words);
+            offsets.reserve(words);
+            histograms.reserve(words);
+        }
+
+        /**
+         * Append a word and its histogram.
+         */
+        void push_back(const std::string& wrd, const astring& astr) {
+            offsets.push_back(pool.size());
+            pool.append(wrd).push_back('\0');
+            histograms.push_back(astr);
+        }
+
+        /**
+         * Append the words of another dictionary.
+         */
+        void append(const Dictionary& dict) {
+            for (uint32_t offset : dict.offsets)
+                offsets.push_back(pool.size() + offset);
+
+            pool.append(dict.pool);
+            histograms.insert(histograms.end(), dict.histograms.begin(), dict.histograms.end());
+        }
+
+    private:
+        Alphabet letters;
+        std::string pool;
+        std::vector<uint32_t> offsets;
+        std::vector<astring> histograms;
+};
+
+/**
+ * Function called on each generated anagram with the indices, in the dictionary, of its words.
+ *
+ * @note the container is only valid during the call.
+ */
+typedef std::function<void(const std::vector<uint32_t>&)> Visitor;
 
 /**
  * Generate all anagrams of a string.
@@ -18,12 +115,98 @@ typedef std::vector<std::pair<std::string, std::array<short, 27>>> Dictionary;
  */
 std::vector<std::vector<std::string>> anagrams(const std::string& input, const Dictionary& dict, unsigned max);
 
+/**
+ * Statistics of the subproblem cache of an anagram search.
+ */
+struct CacheStatistics {
+    size_t size;
+    size_t lookups;
+    size_t hits;
+};
+
+/**
+ * Generate all anagrams of a string and hand them, one at a time, to a visitor.
+ *
+ * @note anagrams are never stored, such that memory usage only grows with the number of words in anagrams and the subproblem cache.
+ *
+ * @param input the string whose anagrams are searched.
+ * @param dict the used dictionary.
+ * @param max the maximum number of words that are allowed in anagrams. If max is null, there is no limit.
+ * @param visit the function called on each generated anagram.
+ * @param stats if not null, filled with the statistics of the subproblem cache.
+ * @return the number of generated anagrams.
+ */
+size_t anagrams(const std::string& input, const Dictionary& dict, unsigned max, const Visitor& visit, CacheStatistics* stats = nullptr);
+
+/**
+ * Anagram query on a base string, refined by required words or by additional letters.
+ *
+ * @note refinements with the same additional letters share the candidate words and the subproblem cache of their first search. The base string and additional letters have at most 255 letters.
+ */
+class Query {
+    public:
+        /**
+         * @param input the base string whose anagrams are searched.
+         * @param dict the used dictionary.
+         * @param max the maximum number of words that are allowed in anagrams. If max is null, there is no limit.
+         */
+        Query(const std::string& input, const Dictionary& dict, unsigned max);
+        ~Query();
+
+        /**
+         * Generate all anagrams of the base string and additional letters that contain some words, and hand them, one at a time, to a visitor.
+         *
+         * @param wrds the words that anagrams must contain, which are handed first to the visitor.
+         * @param letters the letters added to the base string.
+         * @param visit the function called on each generated anagram.
+         * @param stats if not null, filled with the statistics of the subproblem cache.
+         * @return the number of generated anagrams. If a word isn't in the dictionary or doesn't fit in the letters, return 0.
+         */
+        size_t anagrams(const std::vector<std::string>& wrds, const std::string& letters, const Visitor& visit, CacheStatistics* stats = nullptr);
+
+    private:
+        struct State;
+
+        const Dictionary& dict;
+        Histogram<LANES, uint16_t> astr;
+        unsigned max;
+        std::map<Histogram<LANES, uint16_t>, std::unique_ptr<State>> states;
+};
+
+/**
+ * Count all anagrams of a string without generating them.
+ *
+ * @note identical subproblems, i.e. identical residual letters with identical remaining words, are only counted once.
+ *
+ * @param input the string whose anagrams are counted.
+ * @param dict the used dictionary.
+ * @param max the maximum number of words that are allowed in anagrams. If max is null, there is no limit.
+ * @return the number of anagrams.
+ */
+size_t count_anagrams(const std::string& input, const Dictionary& dict, unsigned max);
+
+/**
+ * Generate the anagrams of a string with the fewest words.
+ *
+ * @note branches which cannot lead to fewer words than the current k-th anagram are pruned.
+ *
+ * @param input the string whose anagrams are searched.
+ * @param dict the used dictionary.
+ * @param max the maximum number of words that are allowed in anagrams. If max is null, there is no limit.
+ * @param k the number of generated anagrams.
+ * @return the (at most) k anagrams with the fewest words, sorted by increasing number of words.
+ */
+std::vector<std::vector<std::string>> shortest_anagrams(const std::string& input, const Dictionary& dict, unsigned max, size_t k);
+
 /**
  * Create a dictionary from a file.
  *
+ * @note words with a letter outside the alphabet, or longer than 255 letters, are skipped. Other characters, such as hyphens, are ignored.
+ *
  * @param filename the path to the file.
+ * @param alphabet the alphabet of the words.
  * @return the created dictionary. If non-existent or empty file, return an empty Dictionary.
  */
-Dictionary create_dictionary(const std::string& filename);
+Dictionary create_dictionary(const std::string& filename, const Alphabet& alphabet = Alphabet());
 
 #endif
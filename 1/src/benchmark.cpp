@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include "anagrams.hpp"
+#include "dawg.hpp"
+
+using namespace std;
+
+// Allocations counters, updated by the replaced global operator new
+
+static atomic<size_t> allocations(0), allocated(0);
+
+void* operator new(size_t size) {
+    ++allocations;
+    allocated += size;
+
+    if (void* ptr = malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+/**
+ * Escape a string as a JSON string.
+ */
+static string quote(const string& str) {
+    string quoted = "\"";
+
+    for (char c : str)
+        if (c == '"' || c == '\\')
+            quoted += string("\\") + c;
+        else if (c >= ' ')
+            quoted += c;
+
+    return quoted + "\"";
+}
+
+/**
+ * @return the group of a phrase, by length and letter diversity.
+ */
+static string group(const Histogram<LANES, uint16_t>& astr) {
+    size_t distinct = count_if(astr.begin() + 1, astr.end(), [](uint16_t n) { return n > 0; });
+
+    string length = astr[0] < 10 ? "short" : astr[0] < 15 ? "medium" : "long";
+    string diversity = 2 * distinct < (size_t) astr[0] ? "low" : "high";
+
+    return length + "-" + diversity;
+}
+
+/**
+ * Run the solver on a fixed corpus of phrases and write the results as JSON to the standard output.
+ *
+ * usage: benchmark DICTIONARY PHRASES [--max 1,2,3] [--repeat n]
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: benchmark DICTIONARY PHRASES [--max 1,2,3] [--repeat n]" << endl;
+        exit(1);
+    }
+
+    vector<unsigned> limits = {1, 2, 3};
+    unsigned repeat = 3;
+
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--max" && i + 1 < argc) {
+            limits.clear();
+
+            stringstream list(argv[++i]);
+            string limit;
+            while (getline(list, limit, ','))
+                limits.push_back(strtoul(limit.c_str(), nullptr, 10));
+        } else if (arg == "--repeat" && i + 1 < argc)
+            repeat = max(strtoul(argv[++i], nullptr, 10), 1ul);
+        else {
+            cerr << "error: invalid argument " << arg << endl;
+            exit(1);
+        }
+    }
+
+    ifstream file;
+    file.open(argv[2]);
+
+    if (!file.is_open()) {
+        cerr << "error: " << argv[2] << ": No such file or directory" << endl;
+        exit(1);
+    }
+
+    vector<string> phrases;
+    string line;
+
+    while (getline(file, line))
+        if (!line.empty() && line[0] != '#')
+            phrases.push_back(line);
+
+    file.close();
+
+    // Dictionary creation
+
+    auto start = chrono::steady_clock::now();
+
+    Dictionary dict = create_dictionary(argv[1]);
+
+    auto end = chrono::steady_clock::now();
+    auto time1 = chrono::duration <double, milli> (end - start).count();
+
+    start = chrono::steady_clock::now();
+
+    Dawg graph(dict);
+
+    end = chrono::steady_clock::now();
+    auto time2 = chrono::duration <double, milli> (end - start).count();
+
+    cout << "{" << endl;
+    cout << "  \"dictionary\": " << quote(argv[1]) << "," << endl;
+    cout << "  \"words\": " << dict.size() << "," << endl;
+    cout << "  \"create_dictionary_ms\": " << time1 << "," << endl;
+    cout << "  \"create_dawg_ms\": " << time2 << "," << endl;
+    cout << "  \"runs\": [";
+
+    // Queries
+
+    const string engines[] = {"histogram", "dawg"};
+    bool first = true;
+
+    Visitor ignore = [](const vector<uint32_t>&) {};
+
+    for (const string& phrase : phrases)
+        for (unsigned max : limits)
+            for (const string& engine : engines) {
+                vector<double> times;
+                size_t number = 0, count = 0, bytes = 0;
+
+                for (unsigned i = 0; i < repeat; i++) {
+                    size_t count0 = allocations, bytes0 = allocated;
+
+                    start = chrono::steady_clock::now();
+
+                    if (engine == "dawg")
+                        number = graph.anagrams(phrase, max, ignore);
+                    else
+                        number = anagrams(phrase, dict, max, ignore);
+
+                    end = chrono::steady_clock::now();
+                    times.push_back(chrono::duration <double, milli> (end - start).count());
+
+                    count = allocations - count0;
+                    bytes = allocated - bytes0;
+                }
+
+                sort(times.begin(), times.end());
+
+                Histogram<LANES, uint16_t> astr = histogram<uint16_t>(phrase, dict.alphabet());
+
+                cout << (first ? "\n" : ",\n");
+                cout << "    {\"phrase\": " << quote(phrase) << ", \"group\": " << quote(group(astr)) << ", \"letters\": " << astr[0];
+                cout << ", \"max\": " << max << ", \"engine\": " << quote(engine);
+                cout << ", \"solve_ms\": " << times[times.size() / 2] << ", \"anagrams\": " << number;
+                cout << ", \"allocations\": " << count << ", \"allocated_bytes\": " << bytes << "}";
+                cout.flush();
+
+                first = false;
+            }
+
+    cout << endl << "  ]" << endl << "}" << endl;
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "anagrams.hpp"
+
+using namespace std;
+
+/**
+ * Regression checks of the anagram solver.
+ *
+ * usage: check DICTIONARY
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "error: missing dictionary file" << endl;
+        exit(1);
+    }
+
+    Dictionary dict = create_dictionary(argv[1]);
+    size_t failures = 0;
+
+    // Without a limit, a subproblem reached at several depths (as after "a t" and "at") is a cache hit : the search finds the same anagrams as with a limit it cannot reach, solving fewer subproblems (lookups that miss)
+    for (string input : {"the morse code", "eleven plus two", "mississippi assesses"}) {
+        CacheStatistics unlimited, bounded;
+        auto ignore = [](const vector<uint32_t>&) {};
+
+        size_t number = anagrams(input, dict, 0, ignore, &unlimited);
+        size_t reference = anagrams(input, dict, input.length(), ignore, &bounded);
+
+        if (number != reference || count_anagrams(input, dict, 0) != number || unlimited.hits == 0 || unlimited.lookups - unlimited.hits >= bounded.lookups - bounded.hits) {
+            cerr << "error: " << input << " : " << number << " anagrams (" << unlimited.hits << " cache hits out of " << unlimited.lookups << ") without a limit, ";
+            cerr << reference << " anagrams (" << bounded.hits << " cache hits out of " << bounded.lookups << ") with a limit of " << input.length() << " words" << endl;
+            failures++;
+        }
+    }
+
+    cout << failures << " failures" << endl;
+
+    return failures > 0 ? 1 : 0;
+}
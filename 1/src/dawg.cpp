@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <unordered_map>
+
+#include "dawg.hpp"
+
+using namespace std;
+
+Dawg::Dawg(const Dictionary& dict) : alphabet(dict.alphabet()) {
+    // Rank the words in lexicographic order, without duplicates
+    indices.resize(dict.size());
+    iota(indices.begin(), indices.end(), 0);
+
+    stable_sort(indices.begin(), indices.end(), [&](uint32_t i, uint32_t j) {
+        return strcmp(dict.word(i), dict.word(j)) < 0;
+    });
+
+    indices.erase(unique(indices.begin(), indices.end(), [&](uint32_t i, uint32_t j) {
+        return strcmp(dict.word(i), dict.word(j)) == 0;
+    }), indices.end());
+
+    // Build the minimal automaton incrementally from the sorted words (Daciuk et al.)
+    struct State {
+        bool terminal;
+        vector<pair<uint8_t, uint32_t>> edges;
+    };
+
+    vector<State> states(1);
+    unordered_map<string, uint32_t> registry;
+    vector<uint32_t> path = {0};
+    string previous;
+
+    // Replace the states of the previous word below a depth by their registered equivalent
+    auto minimize = [&](size_t depth) {
+        while (path.size() > depth + 1) {
+            uint32_t state = path.back();
+            path.pop_back();
+
+            string key(1, states[state].terminal);
+            for (auto& edge : states[state].edges) {
+                key.push_back(edge.first);
+                key.append(reinterpret_cast<const char*>(&edge.second), sizeof(edge.second));
+            }
+
+            auto it = registry.find(key);
+
+            if (it == registry.end())
+                registry.emplace(key, state);
+            else
+                states[path.back()].edges.back().second = it->second;
+        }
+    };
+
+    for (uint32_t i : indices) {
+        string wrd = dict.word(i);
+
+        size_t common = 0;
+        while (common < wrd.length() && common < previous.length() && wrd[common] == previous[common])
+            ++common;
+
+        minimize(common);
+
+        for (size_t j = common; j < wrd.length(); ++j) {
+            states[path.back()].edges.emplace_back(alphabet.lane(wrd[j]), states.size());
+            path.push_back(states.size());
+            states.push_back({false, {}});
+        }
+
+        states[path.back()].terminal = true;
+        previous = wrd;
+    }
+
+    minimize(0);
+
+    // Flatten the reachable states, counting the words each one leads to
+    vector<uint32_t> ids(states.size(), UINT32_MAX);
+
+    function<uint32_t(uint32_t)> flatten = [&](uint32_t state) {
+        if (ids[state] != UINT32_MAX)
+            return ids[state];
+
+        vector<Edge> own;
+        uint32_t words = states[state].terminal;
+
+        for (auto& edge : states[state].edges) {
+            uint32_t target = flatten(edge.second);
+            own.push_back({target, edge.first});
+            words += nodes[target].words;
+        }
+
+        ids[state] = nodes.size();
+        nodes.push_back({(uint32_t) edges.size(), words, (uint8_t) own.size(), states[state].terminal});
+        edges.insert(edges.end(), own.begin(), own.end());
+
+        return ids[state];
+    };
+
+    root = flatten(0);
+}
+
+/**
+ * State of an anagram search in a graph.
+ */
+struct Dawg::Search {
+    Histogram<LANES, uint16_t> astr;
+    vector<uint32_t> wrds;
+    const Visitor& visit;
+    size_t count;
+};
+
+size_t Dawg::anagrams(const string& input, unsigned max, const Visitor& visit) const {
+    Search search = {histogram<uint16_t>(input, alphabet), {}, visit, 0};
+
+    if (search.astr[0] > 0)
+        this->build(search, 0, max == 0 ? -1 : max);
+
+    return search.count;
+}
+
+void Dawg::build(Search& search, uint32_t lower, int max) const {
+    if (max == 0)
+        return;
+
+    this->walk(search, root, 0, lower, max);
+}
+
+void Dawg::walk(Search& search, uint32_t node, uint32_t rank, uint32_t lower, int max) const {
+    const Node& n = nodes[node];
+
+    if (n.terminal) {
+        if (rank >= lower) {
+            search.wrds.push_back(indices[rank]);
+
+            if (search.astr[0] == 0) {
+                search.visit(search.wrds);
+                ++search.count;
+            } else
+                this->build(search, rank, max - 1);
+
+            search.wrds.pop_back();
+        }
+
+        ++rank;
+    }
+
+    if (search.astr[0] == 0)
+        return;
+
+    for (auto it = edges.begin() + n.first; it != edges.begin() + n.first + n.degree; ++it) {
+        uint32_t words = nodes[it->target].words;
+
+        // Words before the lower bound have already been combined
+        if (rank + words > lower && search.astr[it->letter] > 0) {
+            --search.astr[it->letter];
+            --search.astr[0];
+
+            this->walk(search, it->target, rank, lower, max);
+
+            ++search.astr[it->letter];
+            ++search.astr[0];
+        }
+
+        rank += words;
+    }
+}
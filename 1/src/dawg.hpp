@@ -0,0 +1,69 @@
+#ifndef DAWG
+#define DAWG
+
+#include "anagrams.hpp"
+
+/**
+ * Directed acyclic word graph : a minimal automaton recognizing the words of a dictionary.
+ *
+ * @note words are ranked in lexicographic order. Each node knows how many words it leads to, such that the rank of a word is computed while walking the graph.
+ */
+class Dawg {
+    public:
+        /**
+         * Build the graph of a dictionary.
+         *
+         * @param dict the dictionary. Duplicated words are only recognized once. Edges are labelled by the histogram lanes of its alphabet.
+         */
+        Dawg(const Dictionary& dict);
+
+        /**
+         * @return the number of nodes.
+         */
+        size_t size() const { return nodes.size(); }
+
+        /**
+         * Generate all anagrams of a string and hand them, one at a time, to a visitor.
+         *
+         * @note the graph is walked while consuming letters of the residual, such that all words sharing an unavailable prefix are pruned at once.
+         *
+         * @param input the string whose anagrams are searched.
+         * @param max the maximum number of words that are allowed in anagrams. If max is null, there is no limit.
+         * @param visit the function called on each generated anagram, with the indices of its words in the dictionary of the graph.
+         * @return the number of generated anagrams.
+         */
+        size_t anagrams(const std::string& input, unsigned max, const Visitor& visit) const;
+
+    private:
+        struct Node {
+            uint32_t first;
+            uint32_t words;
+            uint8_t degree;
+            bool terminal;
+        };
+
+        struct Edge {
+            uint32_t target;
+            uint8_t letter;
+        };
+
+        Alphabet alphabet;
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+        std::vector<uint32_t> indices;
+        uint32_t root;
+
+        struct Search;
+
+        /**
+         * Search the anagrams of the residual starting with a word whose rank is not smaller than the lower bound.
+         */
+        void build(Search& search, uint32_t lower, int max) const;
+
+        /**
+         * Walk the words of the graph from a node, recursively.
+         */
+        void walk(Search& search, uint32_t node, uint32_t rank, uint32_t lower, int max) const;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include <cctype>
+
+#include "histogram.hpp"
+
+using namespace std;
+
+Alphabet::Alphabet(const string& letters) : letters(letters.substr(0, MAX)) {
+    this->lanes.fill(0);
+
+    for (size_t i = 0; i < this->letters.size(); ++i)
+        this->lanes[(unsigned char) this->letters[i]] = i + 1;
+
+    for (size_t i = 0; i < this->letters.size(); ++i) {
+        unsigned char c = this->letters[i];
+
+        if (islower(c) && this->lanes[toupper(c)] == 0)
+            this->lanes[toupper(c)] = i + 1;
+    }
+}
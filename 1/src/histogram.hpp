@@ -0,0 +1,145 @@
+#ifndef HISTOGRAM
+#define HISTOGRAM
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * Compute the number of lanes of histograms over an alphabet.
+ *
+ * @param letters the number of letters of the alphabet.
+ * @param n the minimum number of lanes.
+ * @return the smallest power of two, not smaller than n, with a lane for the length and a lane for each letter.
+ */
+constexpr size_t lanes(size_t letters, size_t n = 16) {
+    return letters < n ? n : lanes(letters, 2 * n);
+}
+
+/**
+ * Letter histogram of a string : the first lane is the length of the string, the following ones the numbers of each letter of an alphabet. Remaining lanes are null.
+ *
+ * @note with a power of two lanes of small counters, the whole histogram is processed by a few vector instructions.
+ */
+template <size_t N, typename T>
+using Histogram = std::array<T, N>;
+
+/**
+ * Mapping of characters to histogram lanes.
+ */
+class Alphabet {
+    public:
+        /**
+         * Maximum number of letters of an alphabet.
+         */
+        static const size_t MAX = 31;
+
+        /**
+         * @param letters the letters of the alphabet. Only the MAX first letters are kept. The uppercases of lowercase letters are mapped to the same lanes.
+         */
+        Alphabet(const std::string& letters = "abcdefghijklmnopqrstuvwxyz");
+
+        /**
+         * @return the number of letters.
+         */
+        size_t size() const { return letters.size(); }
+
+        /**
+         * @return the lane of a character, 0 if it isn't a letter of the alphabet.
+         */
+        uint8_t lane(char c) const { return lanes[(unsigned char) c]; }
+
+        /**
+         * @return the letter of a (non-null) lane.
+         */
+        char letter(uint8_t lane) const { return letters[lane - 1]; }
+
+    private:
+        std::string letters;
+        std::array<uint8_t, 256> lanes;
+};
+
+/**
+ * Number of lanes of histograms over any alphabet.
+ */
+const size_t LANES = lanes(Alphabet::MAX);
+
+/**
+ * Compute the histogram of a string, ignoring the characters which aren't letters of an alphabet.
+ *
+ * @param str a string.
+ * @param alphabet the alphabet.
+ * @return the histogram.
+ */
+template <typename T>
+Histogram<LANES, T> histogram(const std::string& str, const Alphabet& alphabet) {
+    Histogram<LANES, T> astr = {};
+
+    for (char c : str)
+        if (uint8_t l = alphabet.lane(c)) {
+            ++astr[0];
+            ++astr[l];
+        }
+
+    return astr;
+}
+
+/**
+ * Convert the counters of a histogram.
+ *
+ * @note counters should fit in the new type.
+ */
+template <typename T, size_t N, typename U>
+Histogram<N, T> convert(const Histogram<N, U>& astr) {
+    Histogram<N, T> conv;
+    for (size_t i = 0; i < N; ++i)
+        conv[i] = astr[i];
+
+    return conv;
+}
+
+/**
+ * Search if a histogram is a subset of another.
+ *
+ * @param[in] astr a histogram.
+ * @param[in] asub a supposed subset.
+ * @return true if asub is a subset of astr, false otherwise.
+ */
+template <size_t N, typename T, typename U>
+inline bool isSub(const Histogram<N, T>& astr, const Histogram<N, U>& asub) {
+    T over = 0;
+    for (size_t i = 0; i < N; ++i)
+        over |= asub[i] > astr[i];
+
+    return !over;
+}
+
+/**
+ * Search if a histogram is a subset of another and compute the residual if so.
+ *
+ * @note the loop is branch-free, such that it is vectorized : a lane underflows if its residual exceeds its count.
+ *
+ * @param[in] astr a histogram.
+ * @param[in] asub a supposed subset.
+ * @param[out] ares the residual, unspecified if asub isn't a subset.
+ * @return true if asub is a subset of astr, false otherwise.
+ */
+template <size_t N, typename T>
+inline bool isRes(const Histogram<N, T>& astr, const Histogram<N, T>& asub, Histogram<N, T>& ares) {
+    if (astr[0] < asub[0])
+        return false;
+
+    Histogram<N, T> res;
+    T under = 0;
+
+    for (size_t i = 0; i < N; ++i) {
+        res[i] = astr[i] - asub[i];
+        under |= res[i] > astr[i];
+    }
+
+    ares = res;
+
+    return !under;
+}
+
+#endif
@@ -1,61 +1,361 @@
+#include <atomic>
+#include <cctype>
+#include <cerrno>
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <thread>
 #include "anagrams.hpp"
+#include "dawg.hpp"
 
 using namespace std;
 
+/**
+ * Query mode : all anagrams (default), count only (--count) or the k with the fewest words (--top k).
+ *
+ * @note all anagrams are generated by the DAWG engine if dawg isn't null, or by query if it isn't null.
+ */
+struct Mode {
+    bool counting;
+    size_t top;
+    const Dawg* dawg;
+    Query* query;
+};
+
+/**
+ * Result of a query.
+ */
+struct Result {
+    size_t number;
+    double time;
+    CacheStatistics stats;
+};
+
+/**
+ * Write the time, the number of anagrams and the cache statistics of a query.
+ */
+static void report(ostream& out, const Result& result) {
+    out << "anagrams time : " << result.time << " ms" << "\n";
+    out << "anagrams number : " << result.number << "\n";
+    if (result.stats.lookups > 0)
+        out << "cache size : " << result.stats.size << ", hit rate : " << 100. * result.stats.hits / result.stats.lookups << " %\n";
+}
+
+/**
+ * Write the words of an anagram on a line.
+ */
+static void write(ostream& out, const Dictionary& dict, const vector<uint32_t>& wrds) {
+    for (auto it = wrds.begin(); it != wrds.end(); it++)
+        out << dict.word(*it) << ' ';
+
+    out << "\n";
+}
+
+/**
+ * Solve a query and write its anagrams to a file.
+ *
+ * @param input the string whose anagrams are searched.
+ * @param dict the used dictionary.
+ * @param max the maximum number of words that are allowed in anagrams.
+ * @param mode the query mode.
+ * @param file the output file, which receives the input, the anagrams and the result summary.
+ * @param time1 the create_dictionary time written in the summary.
+ * @return the result of the query.
+ */
+static Result solve(const string& input, const Dictionary& dict, unsigned max, const Mode& mode, ofstream& file, double time1) {
+    Result result = {0, 0, {0, 0, 0}};
+
+    file << input + "\n\n";
+
+    auto start = chrono::steady_clock::now();
+
+    if (mode.counting)
+        result.number = count_anagrams(input, dict, max);
+    else if (mode.top > 0) {
+        vector<vector<string>> vect = shortest_anagrams(input, dict, max, mode.top);
+
+        for (auto it = vect.begin(); it != vect.end(); it++) {
+            for (auto it2 = (*it).begin(); it2 != (*it).end(); it2++)
+                file << *it2 + " ";
+
+            file << "\n";
+        }
+
+        result.number = vect.size();
+    } else {
+        Visitor visit = [&](const vector<uint32_t>& wrds) { write(file, dict, wrds); };
+
+        if (mode.dawg != nullptr)
+            result.number = mode.dawg->anagrams(input, max, visit);
+        else if (mode.query != nullptr)
+            result.number = mode.query->anagrams({}, "", visit, &result.stats);
+        else
+            result.number = anagrams(input, dict, max, visit, &result.stats);
+    }
+
+    auto end = chrono::steady_clock::now();
+    result.time = chrono::duration <double, milli> (end - start).count();
+
+    file << "\n";
+    file << "create_dictionary time : " << time1 << " ms" << "\n";
+    report(file, result);
+
+    return result;
+}
+
+/**
+ * Solve, in parallel, one query per line of a stream. The anagrams of the ith line are written to anagram-i.txt.
+ *
+ * @param in the stream of queries.
+ * @param dict the used dictionary.
+ * @param max the maximum number of words that are allowed in anagrams.
+ * @param mode the query mode.
+ * @param threads the number of worker threads.
+ * @param time1 the create_dictionary time written in the summaries.
+ */
+static void batch(istream& in, const Dictionary& dict, unsigned max, const Mode& mode, unsigned threads, double time1) {
+    vector<string> inputs;
+    string line;
+
+    while (getline(in, line))
+        inputs.push_back(line);
+
+    vector<Result> results(inputs.size());
+    atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            ofstream file;
+            file.open("anagram-" + to_string(i + 1) + ".txt");
+
+            results[i] = solve(inputs[i], dict, max, mode, file, time1);
+
+            file.close();
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> pool;
+    for (unsigned i = 1; i < threads; i++)
+        pool.emplace_back(worker);
+    worker();
+
+    for (auto& t : pool)
+        t.join();
+
+    auto end = chrono::steady_clock::now();
+    auto time = chrono::duration <double, milli> (end - start).count();
+
+    for (size_t i = 0; i < inputs.size(); i++)
+        cout << "anagram-" << i + 1 << ".txt : " << inputs[i] << " : " << results[i].number << " anagrams in " << results[i].time << " ms" << endl;
+
+    cout << "create_dictionary time : " << time1 << " ms" << endl;
+    cout << "batch time : " << time << " ms (" << inputs.size() << " queries, " << threads << " threads)" << endl;
+}
+
+/**
+ * Refine interactively a query. The anagrams of the ith refinement are written to anagram-i.txt.
+ *
+ * @param input the base string of the query.
+ * @param dict the used dictionary.
+ * @param query the query, already solved on its base string.
+ */
+static void refine(const string& input, const Dictionary& dict, Query& query) {
+    string line;
+
+    for (unsigned i = 1; ; i++) {
+        cout << "Refine (+word to require a word, letters to add them, nothing to quit) :" << endl;
+
+        if (!getline(cin, line) || line.empty())
+            break;
+
+        vector<string> wrds;
+        string letters, token;
+        stringstream tokens(line);
+
+        while (tokens >> token)
+            if (token[0] == '+')
+                wrds.push_back(token.substr(1));
+            else
+                letters += token;
+
+        ofstream file;
+        file.open("anagram-" + to_string(i) + ".txt");
+
+        file << input + " " + line + "\n\n";
+
+        Result result = {0, 0, {0, 0, 0}};
+
+        auto start = chrono::steady_clock::now();
+
+        result.number = query.anagrams(wrds, letters, [&](const vector<uint32_t>& wrds) { write(file, dict, wrds); }, &result.stats);
+
+        auto end = chrono::steady_clock::now();
+        result.time = chrono::duration <double, milli> (end - start).count();
+
+        file << "\n";
+        report(file, result);
+
+        file.close();
+
+        cout << "anagram-" << i << ".txt" << endl;
+        report(cout, result);
+    }
+}
+
+/**
+ * Parse a non-negative integer option value.
+ *
+ * @param str the value, in decimal
+ * @param[out] value the parsed value
+ * @return whether the value is a valid integer, within unsigned
+ */
+static bool number(const char* str, unsigned& value) {
+    char* end;
+    errno = 0;
+    unsigned long n = strtoul(str, &end, 10);
+
+    if (!isdigit(static_cast<unsigned char>(str[0])) || *end != '\0' || errno != 0 || n > numeric_limits<unsigned>::max())
+        return false;
+
+    value = n;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         cerr << "error: missing dictionary file" << endl;
         exit(1);
     }
 
+    Mode mode = {false, 0, nullptr, nullptr};
+
+    // Refinement mode (--refine) : the base query is refined interactively
+    bool refining = false;
+
+    // Engine (--engine histogram|dawg) generating all anagrams
+    bool dawg = false;
+
+    // Letters of the dictionary words (--alphabet letters)
+    string letters = "abcdefghijklmnopqrstuvwxyz";
+
+    // Batch mode (--batch [file]) : one query per line of file, or of the standard input
+    bool batched = false;
+    string queries;
+    unsigned max = 0, threads = std::max(thread::hardware_concurrency(), 1u), top;
+
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--count")
+            mode.counting = true;
+        else if (arg == "--top" && i + 1 < argc && number(argv[i + 1], top) && top > 0) {
+            mode.top = top;
+            i++;
+        } else if (arg == "--refine")
+            refining = true;
+        else if (arg == "--batch") {
+            batched = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                queries = argv[++i];
+        } else if (arg == "--max" && i + 1 < argc && number(argv[i + 1], max))
+            i++;
+        else if (arg == "--threads" && i + 1 < argc && number(argv[i + 1], threads) && threads > 0)
+            i++;
+        else if (arg == "--engine" && i + 1 < argc && (string(argv[i + 1]) == "histogram" || string(argv[i + 1]) == "dawg"))
+            dawg = string(argv[++i]) == "dawg";
+        else if (arg == "--alphabet" && i + 1 < argc && strlen(argv[i + 1]) <= Alphabet::MAX)
+            letters = argv[++i];
+        else {
+            cerr << "error: invalid argument " << arg << endl;
+            exit(1);
+        }
+    }
+
     auto start = chrono::steady_clock::now();
 
-    Dictionary dict = create_dictionary(argv[1]);
+    Dictionary dict = create_dictionary(argv[1], Alphabet(letters));
 
     auto end = chrono::steady_clock::now();
     auto diff = end - start;
     auto time1 = chrono::duration <double, milli> (diff).count();
 
+    unique_ptr<Dawg> graph;
+
+    if (dawg) {
+        if (mode.counting || mode.top > 0) {
+            cerr << "error: the dawg engine only generates all anagrams" << endl;
+            exit(1);
+        }
+
+        start = chrono::steady_clock::now();
+
+        graph.reset(new Dawg(dict));
+        mode.dawg = graph.get();
+
+        end = chrono::steady_clock::now();
+        diff = end - start;
+
+        cout << "create_dawg time : " << chrono::duration <double, milli> (diff).count() << " ms (" << graph->size() << " nodes)" << endl;
+    }
+
+    if (batched) {
+        if (queries.empty())
+            batch(cin, dict, max, mode, threads, time1);
+        else {
+            ifstream file;
+            file.open(queries);
+
+            if (!file.is_open()) {
+                cerr << "error: " << queries << ": No such file or directory" << endl;
+                exit(1);
+            }
+
+            batch(file, dict, max, mode, threads, time1);
+        }
+
+        return 0;
+    }
+
     string input;
-    unsigned int max;
 
     cout << "Enter a string :" << endl;
     getline(cin, input);
     cout << "Enter a number :" << endl;
     cin >> max;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-    start = chrono::steady_clock::now();
+    unique_ptr<Query> query;
 
-    vector<vector<string>> vect = anagrams(input, dict, max);
+    if (refining) {
+        if (mode.counting || mode.top > 0 || dawg) {
+            cerr << "error: only all anagrams of the histogram engine can be refined" << endl;
+            exit(1);
+        }
 
-    end = chrono::steady_clock::now();
-    diff = end - start;
-    auto time2 = chrono::duration <double, milli> (diff).count();
+        query.reset(new Query(input, dict, max));
+        mode.query = query.get();
+    }
 
     ofstream file;
     file.open("anagram.txt");
 
-    file << input + "\n\n";
-    file << "create_dictionary time : " << time1 << " ms" << "\n";
-    file << "anagrams time : " << time2 << " ms" << "\n";
-    file << "anagrams number : " << vect.size() << "\n\n";
-
-    for (auto it = vect.begin(); it != vect.end(); it++) {
-        for (auto it2 = (*it).begin(); it2 != (*it).end(); *it2++) {
-            file << *it2 + " ";
-        }
-
-        file << "\n";
-    }
+    Result result = solve(input, dict, max, mode, file, time1);
 
     file.close();
 
     cout << "create_dictionary time : " << time1 << " ms" << endl;
-    cout << "anagrams time : " << time2 << " ms" << endl;
-    cout << "anagrams number : " << vect.size() << endl;
+    report(cout, result);
+    cout.flush();
+
+    if (query)
+        refine(input, dict, *query);
 
     return 0;
 }
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "paint.hpp"
+
+using namespace std;
+
+/**
+ * Deterministic pseudo-random generator (linear congruential).
+ */
+class Random {
+	public:
+		explicit Random(uint64_t seed) : state(seed) {}
+
+		/**
+		 * @return a pseudo-random integer in [0, n)
+		 */
+		size_t next(size_t n) {
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return (state >> 33) % n;
+		}
+
+	private:
+		uint64_t state;
+};
+
+/**
+ * Generate a valid synthetic .paint input.
+ *
+ * @note shapes and colors refer to random previous declarations, such that name lookups are scattered over the whole tables.
+ *
+ * @param declarations the number of declarations
+ * @return the lines of the input
+ */
+static vector<string> generate(size_t declarations) {
+	vector<string> input = {"size 1920 1080"};
+	size_t shapes = 0, colors = 0;
+	Random random(declarations);
+
+	auto shape = [&]() { return "s" + to_string(random.next(shapes)); };
+	auto coordinate = [&]() { return to_string(random.next(1000)); };
+
+	while (input.size() <= declarations) {
+		ostringstream line;
+		string name = "s" + to_string(shapes);
+		size_t kind = shapes < 3 ? 0 : random.next(10);
+
+		if (kind == 0)
+			line << "circ " << name << " {" << coordinate() << ' ' << coordinate() << "} " << random.next(50);
+		else if (kind == 1)
+			line << "rect " << name << ' ' << shape() << ".c " << coordinate() << ' ' << coordinate() << ".5";
+		else if (kind == 2)
+			line << "tri " << name << ' ' << shape() << ".ne {" << coordinate() << ' ' << shape() << ".c.y} (+ {1 2} " << shape() << ".w)";
+		else if (kind == 3)
+			line << "shift " << name << " (* {1 2} 3) " << shape();
+		else if (kind == 4)
+			line << "rot " << name << " -30 " << shape() << ".c " << shape();
+		else if (kind == 5)
+			line << "union " << name << " {" << shape() << ' ' << shape() << ' ' << shape() << '}';
+		else if (kind == 6)
+			line << "diff " << name << ' ' << shape() << ' ' << shape();
+		else if (kind == 7 || colors == 0)
+			line << "color k" << colors++ << " {0." << random.next(10) << " 1 .5}";
+		else
+			line << "fill " << shape() << " k" << random.next(colors);
+
+		if (kind < 7)
+			shapes++;
+
+		input.push_back(line.str());
+	}
+
+	return input;
+}
+
+/**
+ * Parse a positive integer option value.
+ *
+ * @param str the value, in decimal
+ * @param[out] value the parsed value
+ * @return whether the value is a valid positive integer
+ */
+static bool positive(const string& str, unsigned long& value) {
+	char* end;
+	errno = 0;
+	value = strtoul(str.c_str(), &end, 10);
+
+	return !str.empty() && isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0 && value > 0;
+}
+
+/**
+ * Validate synthetic .paint inputs of increasing sizes and write the timings as JSON to the standard output.
+ *
+ * usage: benchmark [--sizes 1000,10000,100000,1000000] [--repeat n]
+ */
+int main(int argc, char* argv[]) {
+	vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+	unsigned repeat = 3;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool valid = true;
+
+		if (arg == "--sizes" && i + 1 < argc) {
+			sizes.clear();
+
+			stringstream list(argv[++i]);
+			string size;
+			unsigned long n;
+			while (getline(list, size, ','))
+				if ((valid = positive(size, n)))
+					sizes.push_back(n);
+				else
+					break;
+
+			valid = valid && !sizes.empty();
+		} else if (arg == "--repeat" && i + 1 < argc) {
+			unsigned long n;
+			if ((valid = positive(string(argv[++i]), n) && n <= numeric_limits<unsigned>::max()))
+				repeat = n;
+		} else {
+			cerr << "benchmark: error: invalid argument " << arg << endl;
+			exit(1);
+		}
+
+		if (!valid) {
+			cerr << "benchmark: error: invalid argument " << arg << " " << argv[i] << endl;
+			exit(1);
+		}
+	}
+
+	cout << "{" << endl;
+	cout << "  \"runs\": [";
+
+	for (size_t k = 0; k < sizes.size(); k++) {
+		vector<string> input = generate(sizes[k]);
+
+		size_t bytes = 0;
+		for (const string& line : input)
+			bytes += line.length() + 1;
+
+		vector<double> times;
+		Statistics stats;
+
+		for (unsigned i = 0; i < repeat; i++) {
+			auto start = chrono::steady_clock::now();
+
+			try {
+				stats = Paint::parse(input);
+			} catch (ParseException& e) {
+				cerr << "benchmark: error: generated input:" << e.what() << endl;
+				exit(1);
+			}
+
+			auto end = chrono::steady_clock::now();
+			times.push_back(chrono::duration <double, milli> (end - start).count());
+		}
+
+		sort(times.begin(), times.end());
+		double time = times[times.size() / 2];
+
+		cout << (k == 0 ? "\n" : ",\n");
+		cout << "    {\"declarations\": " << sizes[k] << ", \"bytes\": " << bytes;
+		cout << ", \"shapes\": " << stats.shapes << ", \"colors\": " << stats.colors << ", \"fills\": " << stats.fills;
+		cout << ", \"parse_ms\": " << time << ", \"ns_per_declaration\": " << time * 1e6 / sizes[k] << "}";
+		cout.flush();
+	}
+
+	cout << endl << "  ]" << endl << "}" << endl;
+
+	return 0;
+}
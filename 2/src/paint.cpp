@@ -1,54 +1,34 @@
-#include <iostream>
 #include <algorithm>
 
 #include "paint.hpp"
 
 using namespace std;
 
-ParseException::ParseException(const string& str) {
-	message = str;
-}
-
-const char* ParseException::what() const throw() {
-	return message.c_str();
-}
-
-void Name::parse(Cursor& cursor, vector<string>& names) {
+void Name::parse(Cursor& cursor, Symbols& names) {
 	string name = cursor.nextWord();
 	Name::valid(name);
 
-	if (find(names.begin(), names.end(), name) != names.end())
+	if (!names.declare(name))
 		throw ParseException("already used name " + name);
-
-	names.push_back(name);
 }
 
 void Name::valid(const string& name) {
-	if (name.empty())
-		throw ParseException("expected name, got empty");
-
-	auto it = name.begin();
-	if (!isalpha(*it))
-		throw ParseException("invalid first character " + string(1, *it));
-
-	while (++it != name.end())
-		if (!isalnum(*it) && *it != '_')
-			throw ParseException("invalid character " + string(1, *it));
+	lexer::name(name);
 }
 
-void Name::exist(const string& name, const vector<string>& names) {
+void Name::exist(const string& name, const Symbols& names) {
 	Name::valid(name);
 
-	if (find(names.begin(), names.end(), name) == names.end())
+	if (!names.contains(name))
 		throw ParseException("unknown name " + name);
 }
 
-void Name::parseExist(Cursor& cursor, const vector<string>& names) {
+void Name::parseExist(Cursor& cursor, const Symbols& names) {
 	string name = cursor.nextWord();
 	Name::exist(name, names);
 }
 
-void Number::parse(Cursor& cursor, const vector<string>& shapes) {
+void Number::parse(Cursor& cursor, const Symbols& shapes) {
 	char op = cursor.nextChar();
 
 	if (op == '(' || op == '{' || isalpha(op)) {
@@ -121,7 +101,7 @@ void Number::valid(const string& number) {
 			throw ParseException("invalid character " + string(1, *it));
 }
 
-void Point::parse(Cursor& cursor, const vector<string>& shapes) {
+void Point::parse(Cursor& cursor, const Symbols& shapes) {
 	string word = cursor.nextWord();
 
 	try {
@@ -158,7 +138,7 @@ void Point::parse(Cursor& cursor, const vector<string>& shapes) {
 	}
 }
 
-void Point::valid(const string& point, const vector<string>& shapes) {
+void Point::valid(const string& point, const Symbols& shapes) {
 	size_t pos = point.find('.');
 
 	if (pos == string::npos)
@@ -168,7 +148,7 @@ void Point::valid(const string& point, const vector<string>& shapes) {
 	Name::valid(point.substr(pos + 1));
 }
 
-void Color::keyParse(Cursor& cursor, vector<string>& colors, const vector<string>& shapes) {
+void Color::keyParse(Cursor& cursor, Symbols& colors, const Symbols& shapes) {
 	try {
 		Name::parse(cursor, colors);
 		Color::parse(cursor, colors, shapes);
@@ -177,7 +157,7 @@ void Color::keyParse(Cursor& cursor, vector<string>& colors, const vector<string
 	}
 }
 
-void Color::parse(Cursor& cursor, const vector<string>& colors, const vector<string>& shapes) {
+void Color::parse(Cursor& cursor, const Symbols& colors, const Symbols& shapes) {
 	string word = cursor.nextWord();
 
 	try {
@@ -195,7 +175,7 @@ void Color::parse(Cursor& cursor, const vector<string>& colors, const vector<str
 	}
 }
 
-void Fill::keyParse(Cursor& cursor, const vector<string>& colors, const vector<string>& shapes) {
+void Fill::keyParse(Cursor& cursor, const Symbols& colors, const Symbols& shapes) {
 	try {
 		Name::parseExist(cursor, shapes);
 		Color::parse(cursor, colors, shapes);
@@ -204,7 +184,7 @@ void Fill::keyParse(Cursor& cursor, const vector<string>& colors, const vector<s
 	}
 }
 
-void Circle::keyParse(Cursor& cursor, vector<string>& shapes) {
+void Circle::keyParse(Cursor& cursor, Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 		Point::parse(cursor, shapes);
@@ -214,7 +194,7 @@ void Circle::keyParse(Cursor& cursor, vector<string>& shapes) {
 	}
 }
 
-void Rectangle::keyParse(Cursor& cursor, vector<string>& shapes) {
+void Rectangle::keyParse(Cursor& cursor, Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 		Point::parse(cursor, shapes);
@@ -227,7 +207,7 @@ void Rectangle::keyParse(Cursor& cursor, vector<string>& shapes) {
 }
 
 
-void Triangle::keyParse(Cursor& cursor,vector<string>& shapes) {
+void Triangle::keyParse(Cursor& cursor,Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 
@@ -238,7 +218,7 @@ void Triangle::keyParse(Cursor& cursor,vector<string>& shapes) {
 	}
 }
 
-void Shift::keyParse(Cursor& cursor, vector<string>& shapes) {
+void Shift::keyParse(Cursor& cursor, Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 		Point::parse(cursor, shapes);
@@ -248,7 +228,7 @@ void Shift::keyParse(Cursor& cursor, vector<string>& shapes) {
 	}
 }
 
-void Rotation::keyParse(Cursor& cursor, vector<string>& shapes) {
+void Rotation::keyParse(Cursor& cursor, Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 		Number::parse(cursor, shapes);
@@ -259,7 +239,7 @@ void Rotation::keyParse(Cursor& cursor, vector<string>& shapes) {
 	}
 }
 
-void Union::keyParse(Cursor& cursor, vector<string>& shapes) {
+void Union::keyParse(Cursor& cursor, Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 
@@ -276,7 +256,7 @@ void Union::keyParse(Cursor& cursor, vector<string>& shapes) {
 	}
 }
 
-void Difference::keyParse(Cursor& cursor, vector<string>& shapes) {
+void Difference::keyParse(Cursor& cursor, Symbols& shapes) {
 	try {
 		Name::parse(cursor, shapes);
 
@@ -287,7 +267,7 @@ void Difference::keyParse(Cursor& cursor, vector<string>& shapes) {
 	}
 }
 
-void Frame::keyParse(Cursor& cursor, const vector<string>& shapes) {
+void Frame::keyParse(Cursor& cursor, const Symbols& shapes) {
 	try {
 		for (int i = 0; i < 2; i++)
 			Number::parse(cursor, shapes);
@@ -307,24 +287,42 @@ const string Union::keyword = "union";
 const string Difference::keyword = "diff";
 const string Frame::keyword = "size";
 
-void Paint::parse(const vector<string>& input) {
+Statistics Paint::parse(const vector<string>& input) {
 	Cursor cursor(input);
+	return Paint::parse(cursor, nullptr);
+}
 
-	string keyword = cursor.nextWord();
+Statistics Paint::parse(const vector<string>& input, Diagnostics& diagnostics) {
+	Cursor cursor(input);
+	return Paint::parse(cursor, &diagnostics);
+}
 
-	try {
-		if (keyword != Frame::keyword)
-			throw ParseException("expected " + Frame::keyword + " keyword, got " + keyword);
+/**
+ * @return true if the word starts a declaration (other than the frame one), false otherwise
+ */
+static bool isKeyword(const string& word) {
+	static const string keywords[] = {Color::keyword, Fill::keyword, Circle::keyword, Rectangle::keyword, Triangle::keyword, Shift::keyword, Rotation::keyword, Union::keyword, Difference::keyword};
+	return find(begin(keywords), end(keywords), word) != end(keywords);
+}
+
+Statistics Paint::parse(Cursor& cursor, Diagnostics* diagnostics) {
+	Symbols colors;
+	Symbols shapes;
+	unsigned int fillCount = 0;
 
-		vector<string> colors;
-		vector<string> shapes;
-		unsigned int fillCount = 0;
+	string keyword = cursor.nextWord();
+	bool framed = false;
+
+	while (true) {
+		try {
+			if (!framed) {
+				framed = true;
 
-		Frame::keyParse(cursor, shapes);
+				if (keyword != Frame::keyword)
+					throw ParseException("expected " + Frame::keyword + " keyword, got " + keyword);
 
-		while (true) {
-			keyword = cursor.nextWord();
-			if (keyword == Color::keyword)
+				Frame::keyParse(cursor, shapes);
+			} else if (keyword == Color::keyword)
 				Color::keyParse(cursor, colors, shapes);
 			else if (keyword == Circle::keyword)
 				Circle::keyParse(cursor, shapes);
@@ -344,15 +342,21 @@ void Paint::parse(const vector<string>& input) {
 				fillCount++;
 				Fill::keyParse(cursor, colors, shapes);
 			} else if (keyword.empty()) {
-				cout << "Number of shapes: " << shapes.size() << endl;
-				cout << "Number of colors: " << colors.size() << endl;
-				cout << "Number of fills: " << fillCount << endl;
-				break;
+				return {shapes.size(), colors.size(), fillCount};
 			} else {
 				throw ParseException("invalid keyword " + keyword);
 			}
+		} catch (ParseException& e) {
+			string message = cursor.at() + " error: " + string(e.what()) + '\n' + cursor.graphic();
+
+			if (diagnostics == nullptr)
+				throw ParseException(message);
+
+			// Skip the rest of the faulty declaration
+			diagnostics->report(message);
+			cursor.resync(isKeyword);
 		}
-	} catch (ParseException& e) {
-		throw ParseException(cursor.at() + " error: " + string(e.what()) + '\n' + cursor.graphic());
+
+		keyword = cursor.nextWord();
 	}
-}
\ No newline at end of file
+}
@@ -2,14 +2,9 @@
 #define PAINTER
 
 #include "cursor.hpp"
+#include "lexer.hpp"
 
-class ParseException: public std::exception {
-	public:
-		explicit ParseException(const std::string& str);
-		virtual const char* what() const throw();
-	private:
-		std::string message;
-};
+#include <vector>
 
 class Name {
 	public:
@@ -18,7 +13,7 @@ class Name {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid name or is already used
 		 */
-		static void parse(Cursor& cursor, std::vector<std::string>& names);
+		static void parse(Cursor& cursor, Symbols& names);
 
 		/**
 		 * @throw an error string if the given string isn't a valid name
@@ -28,14 +23,14 @@ class Name {
 		/**
 		 * @throw an error string if the given string isn't a valid name or is unknown
 		 */
-		static void exist(const std::string& name, const std::vector<std::string>& names);
+		static void exist(const std::string& name, const Symbols& names);
 
 		/**
 		 * Parse as an existing name the next token(s) given by cursor.
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid name or is unknown
 		 */
-		static void parseExist(Cursor& cursor, const std::vector<std::string>& names);
+		static void parseExist(Cursor& cursor, const Symbols& names);
 };
 
 class Number {
@@ -45,7 +40,7 @@ class Number {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid number
 		 */
-		static void parse(Cursor& cursor, const std::vector<std::string>& shapes);
+		static void parse(Cursor& cursor, const Symbols& shapes);
 
 	private:
 		/**
@@ -61,14 +56,14 @@ class Point {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid point
 		 */
-		static void parse(Cursor& cursor, const std::vector<std::string>& shapes);
+		static void parse(Cursor& cursor, const Symbols& shapes);
 
 		/**
 		 * Parse as a named point the given string.
 		 *
 		 * @throw an error string if the string isn't a valid named point
 		 */
-		static void valid(const std::string& point, const std::vector<std::string>& shapes);
+		static void valid(const std::string& point, const Symbols& shapes);
 };
 
 class Color {
@@ -80,14 +75,14 @@ class Color {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid color declaration
 		 */
-		static void keyParse(Cursor& cursor, std::vector<std::string>& colors, const std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& colors, const Symbols& shapes);
 
 		/**
 		 * Parse as a color the next token(s) given by cursor.
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid color
 		 */
-		static void parse(Cursor& cursor, const std::vector<std::string>& colors, const std::vector<std::string>& shapes);
+		static void parse(Cursor& cursor, const Symbols& colors, const Symbols& shapes);
 };
 
 class Fill {
@@ -99,7 +94,7 @@ class Fill {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid fill declaration
 		 */
-		static void keyParse(Cursor& cursor, const std::vector<std::string>& colors, const std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, const Symbols& colors, const Symbols& shapes);
 };
 
 class Shape {};
@@ -113,43 +108,43 @@ class Circle : public Shape {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid circle declaration
 		 */
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Rectangle : public Shape {
 	public:
 		static const std::string keyword;
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Triangle : public Shape {
 	public:
 		static const std::string keyword;
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Shift : public Shape {
 	public:
 		static const std::string keyword;
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Rotation : public Shape {
 	public:
 		static const std::string keyword;
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Union : public Shape {
 	public:
 		static const std::string keyword;
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Difference : public Shape {
 	public:
 		static const std::string keyword;
-		static void keyParse(Cursor& cursor, std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, Symbols& shapes);
 };
 
 class Frame {
@@ -161,7 +156,16 @@ class Frame {
 		 *
 		 * @throw an error string if the token(s) is(are)n't a valid frame declaration
 		 */
-		static void keyParse(Cursor& cursor, const std::vector<std::string>& shapes);
+		static void keyParse(Cursor& cursor, const Symbols& shapes);
+};
+
+/**
+ * Numbers of declarations of a .paint file.
+ */
+struct Statistics {
+	size_t shapes;
+	size_t colors;
+	size_t fills;
 };
 
 class Paint {
@@ -171,8 +175,20 @@ class Paint {
 		 * Parse as a .paint file an input.
 		 *
 		 * @throw an error string at the first grammar mistake
+		 * @return the numbers of declarations
 		 */
-		static void parse(const std::vector<std::string>& input);
+		static Statistics parse(const std::vector<std::string>& input);
+
+		/**
+		 * Parse as a .paint file an input, recovering from grammar mistakes : after a faulty declaration, parsing resumes at the next line starting with a keyword, or with a word in its first column.
+		 *
+		 * @param diagnostics the container receiving the error of each faulty declaration
+		 * @return the numbers of declarations
+		 */
+		static Statistics parse(const std::vector<std::string>& input, Diagnostics& diagnostics);
+
+	private:
+		static Statistics parse(Cursor& cursor, Diagnostics* diagnostics);
 };
 
 #endif
\ No newline at end of file
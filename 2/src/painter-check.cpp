@@ -1,39 +1,274 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "paint.hpp"
 
 using namespace std;
 
-int main(int argc, char* argv[]) {
-	if (argc < 2) {
-		cerr << "painter-check: fatal-error: no input file" << endl;
-		exit(1);
-	}
+/**
+ * Outcome of the validation of a file.
+ */
+struct Check {
+	bool done;
+	bool valid;
+	Statistics stats;
+	string diagnostic;
+	double time;
+};
 
-	string filename = argv[1];
-	string line;
-	ifstream file;
+/**
+ * Validate a .paint file.
+ *
+ * @param filename the path to the file
+ * @param recovering whether all errors are reported, or only the first one
+ * @param limit the maximum number of reported errors when recovering
+ * @return the outcome of the validation
+ */
+static Check check(const string& filename, bool recovering, size_t limit) {
+	Check result = {true, false, {0, 0, 0}, "", 0};
+
+	auto start = chrono::steady_clock::now();
 
+	ifstream file;
 	file.open(filename);
 
 	if (!file.is_open()) {
-		cerr << "painter-check: error: " + filename + ": No such file or directory" << endl;
-		exit(1);
+		result.diagnostic = "painter-check: error: " + filename + ": No such file or directory";
+		return result;
 	}
 
 	vector<string> input;
+	string line;
+
 	while (getline(file, line))
 		input.push_back(line);
 
 	file.close();
 
-	try {
-		Paint::parse(input);
-	} catch (ParseException& e) {
-		cerr << filename + ':' + string(e.what()) << endl;
+	if (recovering) {
+		Diagnostics diagnostics(limit);
+		result.stats = Paint::parse(input, diagnostics);
+		result.valid = diagnostics.count() == 0;
+
+		for (const string& message : diagnostics.kept())
+			result.diagnostic += (result.diagnostic.empty() ? "" : "\n") + filename + ':' + message;
+
+		if (diagnostics.count() > diagnostics.kept().size())
+			result.diagnostic += '\n' + filename + ": " + to_string(diagnostics.count() - diagnostics.kept().size()) + " more errors";
+	} else
+		try {
+			result.stats = Paint::parse(input);
+			result.valid = true;
+		} catch (ParseException& e) {
+			result.diagnostic = filename + ':' + string(e.what());
+		}
+
+	auto end = chrono::steady_clock::now();
+	result.time = chrono::duration <double, milli> (end - start).count();
+
+	return result;
+}
+
+/**
+ * Collect the .paint files of a path : the path itself if it isn't a directory, the .paint files below it otherwise, in lexicographic order.
+ * The directories that cannot be opened are reported.
+ *
+ * @param path a file or directory path
+ * @param[out] filenames the container receiving the files
+ * @return whether every directory below the path could be opened
+ */
+static bool collect(const string& path, vector<string>& filenames) {
+	struct stat st;
+
+	if (stat(path.c_str(), &st) < 0 || !S_ISDIR(st.st_mode)) {
+		filenames.push_back(path);
+		return true;
+	}
+
+	DIR* dir = opendir(path.c_str());
+	if (dir == nullptr) {
+		cerr << "painter-check: error: " << path << ": " << strerror(errno) << endl;
+		return false;
+	}
+
+	vector<string> entries;
+	while (dirent* entry = readdir(dir))
+		if (entry->d_name[0] != '.')
+			entries.push_back(entry->d_name);
+
+	closedir(dir);
+
+	sort(entries.begin(), entries.end());
+
+	string prefix = path.back() == '/' ? path : path + '/';
+	const string extension = ".paint";
+	bool readable = true;
+
+	for (const string& entry : entries) {
+		string child = prefix + entry;
+
+		if (stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+			readable = collect(child, filenames) && readable;
+		else if (entry.length() > extension.length() && entry.compare(entry.length() - extension.length(), extension.length(), extension) == 0)
+			filenames.push_back(child);
+	}
+
+	return readable;
+}
+
+/**
+ * Parse a positive integer option value.
+ *
+ * @param str the value, in decimal
+ * @param[out] value the parsed value
+ * @return whether the value is a valid positive integer
+ */
+static bool positive(const char* str, unsigned long& value) {
+	char* end;
+	errno = 0;
+	value = strtoul(str, &end, 10);
+
+	return isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0 && value > 0;
+}
+
+/**
+ * Validate several files on a thread pool and report them in order, as soon as the previous ones are reported.
+ *
+ * @return the number of invalid files
+ */
+static size_t checkAll(const vector<string>& filenames, unsigned threads, bool timing, bool recovering, size_t limit) {
+	vector<Check> results(filenames.size());
+	atomic<size_t> next(0);
+	mutex lock;
+	condition_variable ready;
+
+	auto worker = [&]() {
+		for (size_t i = next++; i < filenames.size(); i = next++) {
+			Check result = check(filenames[i], recovering, limit);
+
+			lock_guard<mutex> guard(lock);
+			results[i] = move(result);
+			ready.notify_all();
+		}
+	};
+
+	auto start = chrono::steady_clock::now();
+
+	// The main thread only reports, such that diagnostics are streamed while files are validated
+	vector<thread> pool;
+	for (size_t i = 0; i < min<size_t>(threads, filenames.size()); i++)
+		pool.emplace_back(worker);
+
+	size_t invalid = 0;
+
+	for (size_t i = 0; i < filenames.size(); i++) {
+		unique_lock<mutex> guard(lock);
+		ready.wait(guard, [&]() { return results[i].done; });
+		guard.unlock();
+
+		const Check& result = results[i];
+
+		if (result.valid) {
+			cout << filenames[i] << ": " << result.stats.shapes << " shapes, " << result.stats.colors << " colors, " << result.stats.fills << " fills";
+			if (timing)
+				cout << " (" << result.time << " ms)";
+			cout << endl;
+		} else {
+			cerr << result.diagnostic << endl;
+			invalid++;
+		}
+	}
+
+	for (auto& t : pool)
+		t.join();
+
+	auto end = chrono::steady_clock::now();
+
+	cout << filenames.size() << " files checked, " << invalid << " invalid";
+	if (timing)
+		cout << " in " << chrono::duration <double, milli> (end - start).count() << " ms (" << threads << " threads)";
+	cout << endl;
+
+	return invalid;
+}
+
+/**
+ * usage: painter-check [--threads n] [--time] [--all] [--max-errors n] PATH...
+ *
+ * A single file is validated as is. Several files or directories, whose .paint files are searched recursively, are validated concurrently.
+ * With --all, every faulty declaration of a file is reported (at most --max-errors, 100 by default), not only the first one.
+ */
+int main(int argc, char* argv[]) {
+	vector<string> paths;
+	unsigned threads = max(thread::hardware_concurrency(), 1u);
+	bool timing = false, recovering = false;
+	size_t limit = 100;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		unsigned long value;
+
+		if (arg == "--threads" && i + 1 < argc && positive(argv[i + 1], value) && value <= numeric_limits<unsigned>::max()) {
+			threads = value;
+			i++;
+		} else if (arg == "--time")
+			timing = true;
+		else if (arg == "--all")
+			recovering = true;
+		else if (arg == "--max-errors" && i + 1 < argc && positive(argv[i + 1], value)) {
+			limit = value;
+			i++;
+		} else if (arg.compare(0, 2, "--") == 0) {
+			cerr << "painter-check: error: invalid argument " << arg << endl;
+			exit(1);
+		} else
+			paths.push_back(arg);
+	}
+
+	if (paths.empty()) {
+		cerr << "painter-check: fatal-error: no input file" << endl;
 		exit(1);
 	}
 
-	return 0;
-}
\ No newline at end of file
+	struct stat st;
+
+	if (paths.size() == 1 && !(stat(paths[0].c_str(), &st) == 0 && S_ISDIR(st.st_mode))) {
+		Check result = check(paths[0], recovering, limit);
+
+		if (!result.valid) {
+			cerr << result.diagnostic << endl;
+			exit(1);
+		}
+
+		cout << "Number of shapes: " << result.stats.shapes << endl;
+		cout << "Number of colors: " << result.stats.colors << endl;
+		cout << "Number of fills: " << result.stats.fills << endl;
+
+		if (timing)
+			cout << "Checked in " << result.time << " ms" << endl;
+
+		return 0;
+	}
+
+	vector<string> filenames;
+	bool readable = true;
+
+	for (const string& path : paths)
+		readable = collect(path, filenames) && readable;
+
+	return checkAll(filenames, threads, timing, recovering, limit) > 0 || !readable ? 1 : 0;
+}
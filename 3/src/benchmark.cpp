@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "parser.hpp"
+
+using namespace std;
+
+/**
+ * Output buffer discarding its input, such that writing an image measures its encoding only.
+ */
+class NullBuffer : public streambuf {
+	protected:
+		int overflow(int c) { return c; };
+		streamsize xsputn(const char*, streamsize n) { return n; };
+};
+
+/**
+ * Durations of the repetitions of a stage.
+ */
+class Samples {
+	public:
+		void add(instant start, instant end) { times.push_back(chrono::duration <double, milli> (end - start).count()); };
+
+		/**
+		 * @return the p-quantile (nearest rank) of the durations, in ms
+		 */
+		double quantile(double p) const {
+			vector<double> sorted = times;
+			sort(sorted.begin(), sorted.end());
+
+			size_t rank = size_t(ceil(p * sorted.size()));
+			return sorted[rank > 0 ? rank - 1 : 0];
+		};
+
+		string json() const {
+			ostringstream out;
+			out << "{\"median\": " << this->quantile(0.5) << ", \"p99\": " << this->quantile(0.99) << "}";
+			return out.str();
+		};
+
+	private:
+		vector<double> times;
+};
+
+/**
+ * Run of the benchmark : a scene, a scale and a number of threads.
+ */
+typedef tuple<string, double, unsigned> Run;
+
+/**
+ * Parse a positive integer option value.
+ *
+ * @param str the value, in decimal
+ * @param[out] value the parsed value
+ * @return whether the value is a valid positive integer
+ */
+static bool positive(const string& str, unsigned long& value) {
+	char* end;
+	errno = 0;
+	value = strtoul(str.c_str(), &end, 10);
+
+	return !str.empty() && isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0 && value > 0;
+}
+
+/**
+ * Parse a positive real option value.
+ *
+ * @param str the value
+ * @param[out] value the parsed value
+ * @return whether the value is a valid, finite and positive real
+ */
+static bool positive(const string& str, double& value) {
+	char* end;
+	value = strtod(str.c_str(), &end);
+
+	return !str.empty() && end != str.c_str() && *end == '\0' && isfinite(value) && value > 0;
+}
+
+/**
+ * Read the render times of a previous output of the benchmark.
+ * The program exits with an error if the file cannot be read, or if one of its runs cannot be parsed.
+ *
+ * @return the median render time (ms) of every run
+ */
+static map<Run, double> baseline(const string& filename) {
+	map<Run, double> times;
+	ifstream file(filename);
+	string line;
+
+	if (!file.is_open()) {
+		cerr << "benchmark: error: " + filename + ": No such file or directory" << endl;
+		exit(1);
+	}
+
+	const string scene = "\"scene\": \"", scale = "\"scale\": ", threads = "\"threads\": ", render = "\"render_ms\": {\"median\": ";
+
+	// The value following a key in the current line, if it is a finite number
+	auto field = [&line](const string& key, double& value) {
+		size_t pos = line.find(key);
+		if (pos == string::npos)
+			return false;
+
+		const char* begin = line.c_str() + pos + key.length();
+		char* end;
+		value = strtod(begin, &end);
+
+		return end != begin && isfinite(value);
+	};
+
+	for (size_t number = 1; getline(file, line); number++) {
+		size_t i = line.find(scene);
+
+		if (i == string::npos && line.find(scale) == string::npos && line.find(render) == string::npos)
+			continue;
+
+		size_t quote = i == string::npos ? i : line.find('"', i += scene.length());
+		double factor, time, n = 1;
+
+		bool valid = quote != string::npos && field(scale, factor) && factor > 0 && field(render, time)
+			&& (line.find(threads) == string::npos || (field(threads, n) && n >= 1 && n == floor(n) && n <= numeric_limits<unsigned>::max()));
+
+		if (!valid) {
+			cerr << "benchmark: error: " + filename + ":" << number << ": invalid run" << endl;
+			exit(1);
+		}
+
+		times[Run(line.substr(i, quote - i), factor, unsigned(n))] = time;
+	}
+
+	return times;
+}
+
+/**
+ * Render .paint files at several scales and on several numbers of threads, and write the timings of every stage as JSON to the standard output.
+ * With --baseline, the render times are compared, on the standard error, with those of a previous output.
+ *
+ * The images are encoded in the --format format (ppm by default).
+ *
+ * usage: benchmark [--scales 1,2,4,8,16] [--threads 1,2,4,8] [--repeat n] [--format ppm|png|qoi] [--baseline FILE] FILE...
+ */
+int main(int argc, char* argv[]) {
+	vector<double> scales = {1, 2, 4, 8, 16};
+	vector<unsigned> counts = {1, 2, 4, 8};
+	unsigned repeat = 5;
+	string format = "ppm";
+	vector<string> filenames;
+	map<Run, double> previous;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool valid = true;
+
+		if (arg == "--scales" && i + 1 < argc) {
+			scales.clear();
+
+			stringstream list(argv[++i]);
+			string scale;
+			double factor;
+			while (getline(list, scale, ','))
+				if ((valid = positive(scale, factor)))
+					scales.push_back(factor);
+				else
+					break;
+
+			valid = valid && !scales.empty();
+		} else if (arg == "--threads" && i + 1 < argc) {
+			counts.clear();
+
+			stringstream list(argv[++i]);
+			string count;
+			unsigned long n;
+			while (getline(list, count, ','))
+				if ((valid = positive(count, n) && n <= numeric_limits<unsigned>::max()))
+					counts.push_back(n);
+				else
+					break;
+
+			valid = valid && !counts.empty();
+		} else if (arg == "--repeat" && i + 1 < argc) {
+			unsigned long n;
+			if ((valid = positive(string(argv[++i]), n) && n <= numeric_limits<unsigned>::max()))
+				repeat = n;
+		} else if (arg == "--format" && i + 1 < argc) {
+			format = argv[++i];
+
+			if (!Encoder::supports(format)) {
+				cerr << "benchmark: error: invalid format " << format << endl;
+				exit(1);
+			}
+		} else if (arg == "--baseline" && i + 1 < argc)
+			previous = baseline(argv[++i]);
+		else if (arg.compare(0, 2, "--") == 0) {
+			cerr << "benchmark: error: invalid argument " << arg << endl;
+			exit(1);
+		} else
+			filenames.push_back(arg);
+
+		if (!valid) {
+			cerr << "benchmark: error: invalid argument " << arg << " " << argv[i] << endl;
+			exit(1);
+		}
+	}
+
+	NullBuffer discard;
+	ostream sink(&discard);
+
+	cout << "{" << endl;
+	cout << "  \"runs\": [";
+
+	bool first = true;
+
+	for (const string& filename : filenames) {
+		string name = filename.substr(filename.find_last_of('/') + 1);
+		name = name.substr(0, name.find_last_of('.'));
+
+		for (double factor : scales) {
+			for (unsigned threads : counts) {
+				Samples read, parse, scale, render, write;
+				size_t width = 0, height = 0;
+
+				for (unsigned r = 0; r < repeat; r++) {
+					// .paint reading
+
+					instant start = chrono::steady_clock::now();
+
+					ifstream file(filename);
+
+					if (!file.is_open()) {
+						cerr << "benchmark: error: " + filename + ": No such file or directory" << endl;
+						exit(1);
+					}
+
+					vector<string> input;
+					string line;
+					while (getline(file, line))
+						input.push_back(line);
+
+					instant end = chrono::steady_clock::now();
+					read.add(start, end);
+
+					// Input parsing
+
+					start = chrono::steady_clock::now();
+
+					Paint paint;
+
+					try {
+						paint = parse::paint(input);
+					} catch (ParseException& e) {
+						cerr << filename + ':' + string(e.what()) << endl;
+						exit(1);
+					}
+
+					end = chrono::steady_clock::now();
+					parse.add(start, end);
+
+					// Canvas scaling
+
+					start = chrono::steady_clock::now();
+
+					if (factor != 1)
+						paint = paint.scale(factor);
+
+					end = chrono::steady_clock::now();
+					scale.add(start, end);
+
+					width = paint.width();
+					height = paint.height();
+
+					// Image computation
+
+					start = chrono::steady_clock::now();
+
+					Image im = paint.image(nullptr, threads);
+
+					end = chrono::steady_clock::now();
+					render.add(start, end);
+
+					// Image encoding
+
+					start = chrono::steady_clock::now();
+
+					Encoder::create(format, sink, im.width(), im.height())->write(im);
+					sink.flush();
+
+					end = chrono::steady_clock::now();
+					write.add(start, end);
+				}
+
+				double mpixels = width * height / (render.quantile(0.5) * 1e3);
+
+				cout << (first ? "\n" : ",\n");
+				cout << "    {\"scene\": \"" << name << "\", \"scale\": " << factor << ", \"threads\": " << threads << ", \"width\": " << width << ", \"height\": " << height;
+				cout << ", \"read_ms\": " << read.json() << ", \"parse_ms\": " << parse.json() << ", \"scale_ms\": " << scale.json();
+				cout << ", \"render_ms\": " << render.json() << ", \"write_ms\": " << write.json() << ", \"mpixels_per_s\": " << mpixels << "}";
+				cout.flush();
+
+				first = false;
+
+				auto it = previous.find(Run(name, factor, threads));
+				if (it != previous.end())
+					cerr << name << " x" << factor << ", " << threads << " threads: render " << render.quantile(0.5) << " ms, baseline " << it->second << " ms (" << it->second / render.quantile(0.5) << "x)" << endl;
+			}
+		}
+	}
+
+	cout << endl << "  ]" << endl << "}" << endl;
+
+	return 0;
+}
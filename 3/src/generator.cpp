@@ -0,0 +1,257 @@
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Deterministic pseudo-random generator (linear congruential).
+ */
+class Random {
+	public:
+		explicit Random(uint64_t seed) : state(seed) {}
+
+		/**
+		 * @return a pseudo-random integer in [0, n)
+		 */
+		size_t next(size_t n) {
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return (state >> 33) % n;
+		}
+
+		/**
+		 * @return a pseudo-random real in [a, b)
+		 */
+		double real(double a, double b) { return a + (b - a) * this->next(1 << 24) / double(1 << 24); }
+
+	private:
+		uint64_t state;
+};
+
+/**
+ * Writer of a random scene.
+ */
+class Generator {
+	public:
+		Generator(ostream& out, uint64_t seed, unsigned fanout, unsigned depth, const vector<string>& primitives) : out(out), random(seed), fanout(fanout), depth(depth), primitives(primitives), shapes(0) {}
+
+		/**
+		 * Declare a filled object : the union of fanout parts, each part being a primitive nested in depth differences or rotations.
+		 *
+		 * @param x, y the center of the object
+		 * @param r the radius of the object
+		 * @return the name of the object
+		 */
+		string object(double x, double y, double r) {
+			if (fanout <= 1)
+				return this->part(x, y, r);
+
+			ostringstream set;
+
+			for (unsigned i = 0; i < fanout; i++) {
+				double angle = random.real(0, 2 * M_PI), distance = random.real(0, r / 2);
+				set << (i > 0 ? " " : "") << this->part(x + distance * cos(angle), y + distance * sin(angle), r / 2);
+			}
+
+			string name = this->name();
+			out << "union " << name << " {" << set.str() << "}" << endl;
+
+			return name;
+		}
+
+		/**
+		 * @return the number of declared shapes
+		 */
+		size_t count() const { return shapes; }
+
+	private:
+		ostream& out;
+		Random random;
+		unsigned fanout, depth;
+		vector<string> primitives;
+		size_t shapes;
+
+		string name() { return "s" + to_string(shapes++); }
+
+		static string point(double x, double y) {
+			ostringstream P;
+			P << '{' << x << ' ' << y << '}';
+			return P.str();
+		}
+
+		string part(double x, double y, double r) {
+			string shape = this->primitive(x, y, r);
+
+			for (unsigned level = 0; level < depth; level++) {
+				string name;
+
+				if (random.next(2) == 0) {
+					name = this->name();
+					out << "rot " << name << ' ' << int(random.next(360)) - 180 << ' ' << point(x, y) << ' ' << shape << endl;
+				} else {
+					string hole = this->primitive(x + random.real(-r, r) / 2, y + random.real(-r, r) / 2, r / 3);
+					name = this->name();
+					out << "diff " << name << ' ' << shape << ' ' << hole << endl;
+				}
+
+				shape = name;
+			}
+
+			return shape;
+		}
+
+		string primitive(double x, double y, double r) {
+			string name = this->name();
+			const string& keyword = primitives[random.next(primitives.size())];
+
+			out << keyword << ' ' << name << ' ';
+
+			if (keyword == "circ")
+				out << point(x, y) << ' ' << r << endl;
+			else if (keyword == "elli")
+				out << point(x, y) << ' ' << r << ' ' << r * random.real(.2, 1) << endl;
+			else if (keyword == "rect")
+				out << point(x, y) << ' ' << r * random.real(.5, 2) << ' ' << r * random.real(.5, 2) << endl;
+			else if (keyword == "poly") {
+				// Star-shaped around the center
+				size_t n = 5 + random.next(12);
+
+				out << (random.next(2) == 0 ? "nonzero" : "evenodd") << " {";
+				for (size_t k = 0; k < n; k++) {
+					double angle = 2 * M_PI * (k + random.real(0, 1)) / n, radius = r * random.real(.4, 1);
+					out << (k > 0 ? " " : "") << point(x + radius * cos(angle), y + radius * sin(angle));
+				}
+				out << '}' << endl;
+			} else
+				out << point(x, y - r) << ' ' << point(x - r, y + r) << ' ' << point(x + r * random.real(-1, 1), y + r) << endl;
+
+			return name;
+		}
+};
+
+/**
+ * Parse a non-negative integer option value.
+ *
+ * @param str the value, in decimal
+ * @param[out] value the parsed value
+ * @param max the largest valid value
+ * @return whether the value is a valid integer, not greater than max
+ */
+static bool integer(const string& str, unsigned long long& value, unsigned long long max = numeric_limits<unsigned long long>::max()) {
+	char* end;
+	errno = 0;
+	value = strtoull(str.c_str(), &end, 10);
+
+	return !str.empty() && isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0 && value <= max;
+}
+
+/**
+ * Write a random valid .paint scene to the standard output.
+ *
+ * The scene has --shapes filled objects, each of them being the union of --fanout parts, each part being a primitive nested in --depth differences or rotations.
+ * Objects are spread uniformly over the canvas, their size being such that every pixel is covered by --overlap objects on average.
+ *
+ * Primitives are drawn among --primitives (circ, elli, rect and tri by default, or poly) ; painter-check, whose grammar has no ellipses nor polygons, needs --primitives circ,rect,tri.
+ *
+ * usage: generator [--shapes n] [--fanout n] [--depth n] [--overlap d] [--size WxH] [--colors n] [--primitives circ,elli,rect,tri] [--seed n]
+ */
+int main(int argc, char* argv[]) {
+	size_t objects = 1000, width = 1920, height = 1080;
+	unsigned fanout = 1, depth = 0, colors = 16;
+	double overlap = 2;
+	uint64_t seed = 1;
+	vector<string> primitives = {"circ", "elli", "rect", "tri"};
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		unsigned long long n;
+		bool valid = true;
+
+		if (arg == "--shapes" && i + 1 < argc) {
+			if ((valid = integer(argv[++i], n, numeric_limits<size_t>::max()) && n > 0))
+				objects = n;
+		} else if (arg == "--fanout" && i + 1 < argc) {
+			if ((valid = integer(argv[++i], n, numeric_limits<unsigned>::max()) && n > 0))
+				fanout = n;
+		} else if (arg == "--depth" && i + 1 < argc) {
+			if ((valid = integer(argv[++i], n, numeric_limits<unsigned>::max())))
+				depth = n;
+		} else if (arg == "--overlap" && i + 1 < argc) {
+			string value = argv[++i];
+			char* end;
+			overlap = strtod(value.c_str(), &end);
+
+			valid = !value.empty() && *end == '\0' && isfinite(overlap) && overlap > 0;
+		} else if (arg == "--size" && i + 1 < argc) {
+			// WxH
+			string size = argv[++i];
+			size_t x = size.find('x');
+			unsigned long long w, h;
+
+			if ((valid = x != string::npos && integer(size.substr(0, x), w, numeric_limits<size_t>::max()) && w > 0 && integer(size.substr(x + 1), h, numeric_limits<size_t>::max()) && h > 0)) {
+				width = w;
+				height = h;
+			}
+		} else if (arg == "--colors" && i + 1 < argc) {
+			if ((valid = integer(argv[++i], n, numeric_limits<unsigned>::max()) && n > 0))
+				colors = n;
+		}
+		else if (arg == "--primitives" && i + 1 < argc) {
+			primitives.clear();
+
+			stringstream list(argv[++i]);
+			string keyword;
+			while (getline(list, keyword, ',')) {
+				if (keyword != "circ" && keyword != "elli" && keyword != "rect" && keyword != "tri" && keyword != "poly") {
+					cerr << "generator: error: invalid primitive " << keyword << endl;
+					exit(1);
+				}
+
+				primitives.push_back(keyword);
+			}
+
+			if (primitives.empty()) {
+				cerr << "generator: error: no primitive" << endl;
+				exit(1);
+			}
+		} else if (arg == "--seed" && i + 1 < argc) {
+			if ((valid = integer(argv[++i], n)))
+				seed = n;
+		} else {
+			cerr << "generator: error: invalid argument " << arg << endl;
+			exit(1);
+		}
+
+		if (!valid) {
+			cerr << "generator: error: invalid argument " << arg << " " << argv[i] << endl;
+			exit(1);
+		}
+	}
+
+	Generator generator(cout, seed, fanout, depth, primitives);
+	Random random(seed + 1);
+
+	// The area of an object is about the one of its enclosing disk
+	double r = sqrt(overlap * width * height / (objects * M_PI));
+
+	cout << "size " << width << ' ' << height << endl;
+
+	for (unsigned k = 0; k < colors; k++)
+		cout << "color k" << k << " {" << random.real(0, 1) << ' ' << random.real(0, 1) << ' ' << random.real(0, 1) << '}' << endl;
+
+	for (size_t i = 0; i < objects; i++) {
+		string name = generator.object(random.real(0, width), random.real(0, height), r);
+		cout << "fill " << name << " k" << random.next(colors) << endl;
+	}
+
+	cerr << generator.count() << " shapes, " << colors << " colors, " << objects << " fills" << endl;
+
+	return 0;
+}
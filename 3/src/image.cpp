@@ -1,25 +1,389 @@
 #include "image.hpp"
 
+#include <array>
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 using namespace std;
 
+static_assert(sizeof(Color) == 3, "rows of pixels are written as rgb bytes");
+
 std::ostream& operator<<(std::ostream& out, const Color& c) {
 	return out << c.r << c.g << c.b;
 }
 
+namespace {
+	/**
+	 * Append an integer to a buffer, in big-endian byte order.
+	 */
+	void put32(vector<uint8_t>& buffer, uint32_t n) {
+		for (int shift = 24; shift >= 0; shift -= 8)
+			buffer.push_back(uint8_t(n >> shift));
+	}
+
+	/**
+	 * Binary 8-bit PPM : a text header, then the raw pixels.
+	 */
+	class Ppm : public Encoder {
+		public:
+			Ppm(ostream& out, size_t width, size_t height) : out(out), width(width) {
+				out << "P6 " << width << " " << height << " 255\n";
+			}
+
+			void row(const Color* pixels) { out.write(reinterpret_cast<const char*>(pixels), 3 * width); }
+
+			void end() {}
+
+		private:
+			ostream& out;
+			size_t width;
+	};
+
+	/**
+	 * QOI (Quite OK Image) : every pixel is encoded relative to the previous one, as a run, an index in a table of recent colors, a small difference or raw.
+	 */
+	class Qoi : public Encoder {
+		public:
+			Qoi(ostream& out, size_t width, size_t height) : out(out), width(width), run(0), index{} {
+				vector<uint8_t> header = {'q', 'o', 'i', 'f'};
+				put32(header, width);
+				put32(header, height);
+				header.push_back(3); // rgb
+				header.push_back(0); // sRGB
+
+				this->flush(header);
+			}
+
+			void row(const Color* pixels) {
+				for (size_t x = 0; x < width; x++) {
+					const Color& c = pixels[x];
+
+					if (c.r == previous.r && c.g == previous.g && c.b == previous.b) {
+						if (++run == 62)
+							this->stop();
+
+						continue;
+					}
+
+					this->stop();
+
+					// Pixels are opaque
+					uint8_t hash = (c.r * 3 + c.g * 5 + c.b * 7 + 255 * 11) % 64;
+					uint32_t rgba = uint32_t(c.r) << 24 | c.g << 16 | c.b << 8 | 255;
+
+					if (index[hash] == rgba)
+						buffer.push_back(hash); // QOI_OP_INDEX
+					else {
+						index[hash] = rgba;
+
+						int8_t dr = c.r - previous.r, dg = c.g - previous.g, db = c.b - previous.b;
+						int8_t dr_dg = dr - dg, db_dg = db - dg;
+
+						if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+							buffer.push_back(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)); // QOI_OP_DIFF
+						else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+							buffer.push_back(0x80 | (dg + 32)); // QOI_OP_LUMA
+							buffer.push_back((dr_dg + 8) << 4 | (db_dg + 8));
+						} else
+							buffer.insert(buffer.end(), {0xfe, c.r, c.g, c.b}); // QOI_OP_RGB
+					}
+
+					previous = c;
+				}
+
+				this->flush(buffer);
+			}
+
+			void end() {
+				this->stop();
+				buffer.insert(buffer.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+
+				this->flush(buffer);
+			}
+
+		private:
+			ostream& out;
+			size_t width;
+			vector<uint8_t> buffer;
+
+			// The previous pixel (initially black) and the number of pixels repeating it
+			Color previous;
+			unsigned run;
+
+			// The colors last seen (rgba), by hash, initially transparent black
+			array<uint32_t, 64> index;
+
+			/**
+			 * End the current run.
+			 */
+			void stop() {
+				if (run > 0)
+					buffer.push_back(0xc0 | (run - 1)); // QOI_OP_RUN
+
+				run = 0;
+			}
+
+			void flush(vector<uint8_t>& bytes) {
+				out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+				bytes.clear();
+			}
+	};
+
+	/**
+	 * PNG : the rows, each one filtered as the difference with the pixel on its left (Sub) or above it (Up), compressed by deflate.
+	 *
+	 * The deflate stream is a single block of fixed Huffman codes, whose only repetitions are runs (matches at distance 1) : the runs of zeros left by the filters in areas of uniform color make most of the compression.
+	 * It is split in IDAT chunks as it is produced.
+	 */
+	class Png : public Encoder {
+		public:
+			Png(ostream& out, size_t width, size_t height) : out(out), width(width), s1(1), s2(0), bits(0), count(0) {
+				const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+				out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+				vector<uint8_t> header;
+				put32(header, width);
+				put32(header, height);
+				header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit rgb, deflate, adaptive filtering, no interlace
+				this->chunk("IHDR", header);
+
+				// zlib header (deflate, 32K window, fastest), then a block of fixed Huffman codes (not final)
+				data = {0x78, 0x01};
+				this->put(2, 3);
+			}
+
+			void row(const Color* pixels) {
+				const uint8_t* current = reinterpret_cast<const uint8_t*>(pixels);
+				size_t n = 3 * width;
+
+				sub.assign(1, 1);
+				for (size_t i = 0; i < n; i++)
+					sub.push_back(current[i] - (i >= 3 ? current[i - 3] : 0));
+
+				// Up is kept when it leaves smaller differences
+				const vector<uint8_t>* filtered = &sub;
+
+				if (!above.empty()) {
+					up.assign(1, 2);
+					for (size_t i = 0; i < n; i++)
+						up.push_back(current[i] - above[i]);
+
+					if (cost(up) < cost(sub))
+						filtered = &up;
+				}
+
+				above.assign(current, current + n);
+
+				this->compress(*filtered);
+
+				if (data.size() >= CHUNK_SIZE) {
+					this->chunk("IDAT", data);
+					data.clear();
+				}
+			}
+
+			void end() {
+				// End of the block, then an empty final block
+				this->put(0, 7);
+				this->put(3, 3);
+				this->put(0, 7);
+
+				if (count > 0)
+					data.push_back(bits);
+
+				put32(data, s2 << 16 | s1);
+
+				this->chunk("IDAT", data);
+				this->chunk("IEND", {});
+			}
+
+		private:
+			static const size_t CHUNK_SIZE = 1 << 16;
+
+			ostream& out;
+			size_t width;
+
+			// The previous row (unfiltered), and the current one filtered both ways, prefixed by their filter type
+			vector<uint8_t> above, sub, up;
+
+			// Adler-32 checksum of the uncompressed data
+			uint32_t s1, s2;
+
+			// Compressed data not yet written, and the bits of its last byte not yet complete
+			vector<uint8_t> data;
+			uint32_t bits;
+			unsigned count;
+
+			/**
+			 * @return the sum of the absolute values of the (signed) differences of a filtered row
+			 */
+			static size_t cost(const vector<uint8_t>& filtered) {
+				size_t sum = 0;
+				for (size_t i = 1; i < filtered.size(); i++)
+					sum += abs(int8_t(filtered[i]));
+
+				return sum;
+			}
+
+			/**
+			 * Append bits to the compressed data, the least significant first.
+			 */
+			void put(uint32_t value, unsigned length) {
+				bits |= value << count;
+				count += length;
+
+				while (count >= 8) {
+					data.push_back(bits);
+					bits >>= 8;
+					count -= 8;
+				}
+			}
+
+			/**
+			 * Append a symbol of the literal/length alphabet by its fixed Huffman code.
+			 */
+			void symbol(unsigned s) {
+				struct Code { uint16_t bits, length; };
+
+				static const array<Code, 288> codes = []() {
+					array<Code, 288> c;
+					for (unsigned s = 0; s < 288; s++) {
+						unsigned code, length;
+
+						if (s < 144)
+							code = 0x30 + s, length = 8;
+						else if (s < 256)
+							code = 0x190 + s - 144, length = 9;
+						else if (s < 280)
+							code = s - 256, length = 7;
+						else
+							code = 0xc0 + s - 280, length = 8;
+
+						// Huffman codes are packed from their most significant bit
+						unsigned reversed = 0;
+						for (unsigned i = 0; i < length; i++)
+							reversed |= (code >> i & 1) << (length - 1 - i);
+
+						c[s] = {uint16_t(reversed), uint16_t(length)};
+					}
+
+					return c;
+				}();
+
+				this->put(codes[s].bits, codes[s].length);
+			}
+
+			/**
+			 * Append a repetition of the previous byte.
+			 *
+			 * @param length the number of repeated bytes, in [3, 258]
+			 */
+			void repeat(unsigned length) {
+				static const unsigned BASE[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+				static const unsigned EXTRA[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+				unsigned k = 28;
+				while (BASE[k] > length)
+					k--;
+
+				this->symbol(257 + k);
+				this->put(length - BASE[k], EXTRA[k]);
+
+				// Distance 1 : code 0, without extra bits
+				this->put(0, 5);
+			}
+
+			/**
+			 * Append a filtered row to the deflate stream.
+			 */
+			void compress(const vector<uint8_t>& row) {
+				for (size_t i = 0; i < row.size(); ) {
+					size_t run = 0;
+					if (i > 0)
+						while (i + run < row.size() && run < 258 && row[i + run] == row[i - 1])
+							run++;
+
+					if (run >= 3) {
+						this->repeat(run);
+						i += run;
+					} else
+						this->symbol(row[i++]);
+				}
+
+				// Adler-32, reduced before the sums can overflow
+				for (size_t i = 0; i < row.size(); ) {
+					for (size_t end = min(row.size(), i + 5552); i < end; i++) {
+						s1 += row[i];
+						s2 += s1;
+					}
+
+					s1 %= 65521;
+					s2 %= 65521;
+				}
+			}
+
+			/**
+			 * Write a chunk : its length, type, data and CRC-32 (of its type and data).
+			 */
+			void chunk(const char type[4], const vector<uint8_t>& content) {
+				static const array<uint32_t, 256> table = []() {
+					array<uint32_t, 256> t;
+					for (uint32_t n = 0; n < 256; n++) {
+						uint32_t c = n;
+						for (int k = 0; k < 8; k++)
+							c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+						t[n] = c;
+					}
+
+					return t;
+				}();
+
+				vector<uint8_t> bytes;
+				put32(bytes, content.size());
+				bytes.insert(bytes.end(), type, type + 4);
+				bytes.insert(bytes.end(), content.begin(), content.end());
+
+				uint32_t crc = 0xffffffff;
+				for (size_t i = 4; i < bytes.size(); i++)
+					crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+
+				put32(bytes, crc ^ 0xffffffff);
+
+				out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+			}
+	};
+}
+
+void Encoder::write(const Image& img) {
+	// Reverse Y direction
+	for (size_t y = 0; y < img.height(); y++)
+		this->row(img.row(img.height() - y - 1));
+
+	this->end();
+}
+
+bool Encoder::supports(const string& format) {
+	return format == "ppm" || format == "png" || format == "qoi";
+}
+
+unique_ptr<Encoder> Encoder::create(const string& format, ostream& out, size_t width, size_t height) {
+	if (format == "ppm")
+		return make_unique<Ppm>(out, width, height);
+	else if (format == "png")
+		return make_unique<Png>(out, width, height);
+	else if (format == "qoi")
+		return make_unique<Qoi>(out, width, height);
+	else
+		return nullptr;
+}
+
 ostream& operator<<(ostream& out, const Image& img)
 {
 	assert(img.height() > 0);
 	assert(img.width() > 0);
 
-	// Write header
-	out << "P6 " << img.width() << " " << img.height() << " 255\n";
-
-	// Write pixels
-	for (size_t y = 0; y < img.height(); ++y)
-		for (size_t x = 0; x < img.width(); ++x)
-			out << img(x, img.height() - y - 1); // Reverse Y direction
+	Ppm(out, img.width(), img.height()).write(img);
 
 	return out;
 }
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <iostream>
 #include <memory>
+#include <string>
 
 class Image {
 	public:
@@ -32,12 +33,53 @@ class Image {
 			return _pixels[y * _width + x];
 		}
 
+		// `img.row(y)` returns the `width()` pixels of row `y`
+		const Color* row(size_t y) const {
+			assert(y < _height);
+			return &_pixels[y * _width];
+		}
+
 	private:
 		std::unique_ptr<Color[]> _pixels;
 		size_t _height;
 		size_t _width;
 };
 
+/**
+ * Streaming encoder of an image in a file format : the rows are encoded as they are given, from the top one.
+ */
+class Encoder {
+	public:
+		virtual ~Encoder() = default;
+
+		/**
+		 * Encode the next row.
+		 *
+		 * @param pixels the pixels of the row, from left to right
+		 */
+		virtual void row(const Color* pixels) = 0;
+
+		/**
+		 * Finish the encoding, once every row was given.
+		 */
+		virtual void end() = 0;
+
+		/**
+		 * Encode a whole image.
+		 */
+		void write(const Image& img);
+
+		/**
+		 * @return true if format is the extension of a supported format : ppm (binary 8-bit PPM), png or qoi
+		 */
+		static bool supports(const std::string& format);
+
+		/**
+		 * @return an encoder of an image of the given size to out, or null if the format isn't supported
+		 */
+		static std::unique_ptr<Encoder> create(const std::string& format, std::ostream& out, size_t width, size_t height);
+};
+
 // Write image in binary 8-bit PPM format
 std::ostream& operator<<(std::ostream&, const Image&);
 
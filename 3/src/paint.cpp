@@ -1,31 +1,236 @@
 #include "paint.hpp"
 
+#include <atomic>
+#include <thread>
+
 using namespace std;
 
-Image Paint::image() const {
-	Image im = Image(width, height);
-	unique_ptr<bool[]> isset = make_unique<bool[]>(width * height);
+/**
+ * Distance to the boundary below which a pixel is decided by has() rather than by the sign of its distance, such that rounding errors don't change the image.
+ */
+static const double MARGIN = 1e-6;
+
+/**
+ * Width (pixels) of the domains from which the rasterization of a fill skips runs of pixels by their distance to the boundary.
+ */
+static const int SKIP_WIDTH = 32;
+
+/**
+ * Size (pixels) of the tiles in which the image is rendered : tiles are rendered independently, and a tile spans several rows such that a fill's shapes stay cached over them.
+ */
+static const int TILE_WIDTH = 256;
+static const int TILE_HEIGHT = 32;
+
+Paint Paint::scale(double factor) const {
+	vector<Fill> fills;
+
+	for (const Fill& fill : _fills)
+		fills.push_back({Scale::create(factor, fill.shape), fill.color});
+
+	return Paint(size_t(_width * factor), size_t(_height * factor), fills);
+}
+
+/**
+ * Rasterize a row of a fill : paint the pixels of the row within the shape and not yet covered.
+ *
+ * @param scanline the rasterization of the shape by rows, if any
+ * @param[in,out] row whether each pixel of the row, from abscissa origin, is already painted
+ * @param[out] tested, set the numbers of pixels evaluated and painted
+ */
+static void rasterize(const Shape& shape, Scanline* scanline, vector<Span>& spans, const Color& color, Image& im, int y, int x_min, int x_max, bool row[], int origin, uint64_t& tested, uint64_t& set) {
+	tested = set = 0;
 
-	int w = width - 1, h = height - 1, x_min, y_min, x_max, y_max;
-	Domain dom;
-	Color color;
+	if (scanline) {
+		scanline->spans(double(y) + 0.5, spans);
 
-	for (auto it = fills.rbegin(); it != fills.rend(); it++) {
-		dom = it->shape->domain();
-		color = *(it->color);
+		for (const Span& span : spans) {
+			// Pixels which center is within the span
+			int begin = int(min(max(ceil(span.begin - 0.5), double(x_min)), double(x_max + 1)));
+			int end = int(min(max(ceil(span.end - 0.5), double(x_min)), double(x_max + 1)));
 
-		x_min = max(int(dom.min.x), 0);
-		y_min = max(int(dom.min.y), 0);
-		x_max = min(int(++dom.max.x), w);
-		y_max = min(int(++dom.max.y), h);
+			for (int x = begin; x < end; x++)
+				if (!row[x - origin]) {
+					tested++;
 
-		for (int y = y_min; y <= y_max; y++)
-			for (int x = x_min, i = y * width + x; x <= x_max; x++, i++)
-				if (!isset[i] && it->shape->has(Point(double(x) + 0.5, double(y) + 0.5))) {
 					im(x, y) = color;
-					isset[i] = true;
+					row[x - origin] = true;
+					set++;
 				}
+		}
+
+		return;
 	}
 
+	// Distances only pay off when they skip long runs
+	bool skipping = x_max - x_min >= SKIP_WIDTH;
+
+	for (int x = x_min; x <= x_max; x++) {
+		if (row[x - origin])
+			continue;
+
+		tested++;
+
+		Point P(double(x) + 0.5, double(y) + 0.5);
+		double d = skipping ? shape.distance(P) : 0;
+
+		// Near the boundary, has() decides
+		if (!(abs(d) >= MARGIN)) {
+			if (shape.has(P)) {
+				im(x, y) = color;
+				row[x - origin] = true;
+				set++;
+			}
+
+			continue;
+		}
+
+		// Further, the next pixels closer to P than |d| are on the same side of the boundary
+		double reach = abs(d) - MARGIN;
+		int run = reach < x_max - x ? int(reach) : x_max - x;
+
+		if (d < 0)
+			for (int k = x; k <= x + run; k++)
+				if (!row[k - origin]) {
+					im(k, y) = color;
+					row[k - origin] = true;
+					set++;
+				}
+
+		x += run;
+	}
+}
+
+void Progress::complete(size_t rows) {
+	{
+		lock_guard<std::mutex> lock(mutex);
+		this->rows = rows;
+	}
+
+	changed.notify_all();
+}
+
+size_t Progress::wait(size_t rows) {
+	unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [&]() { return this->rows > rows; });
+
+	return this->rows;
+}
+
+Image Paint::image(Profile* profile, unsigned threads) const {
+	Image im = Image(_width, _height);
+
+	this->render(im, profile, threads);
+
 	return im;
 }
+
+void Paint::render(Image& im, Profile* profile, unsigned threads, Progress* progress) const {
+	int w = _width - 1, h = _height - 1;
+	size_t columns = (_width + TILE_WIDTH - 1) / TILE_WIDTH, rows = (_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+	struct Bounds { int x_min, y_min, x_max, y_max; };
+	vector<Bounds> bounds(_fills.size());
+
+	// Binning : the fills which domain overlaps each tile, in declaration order
+	vector<vector<uint32_t>> bins(columns * rows);
+
+	for (size_t k = 0; k < _fills.size(); k++) {
+		Domain dom = _fills[k].shape->domain();
+
+		Bounds& b = bounds[k];
+		b.x_min = max(int(dom.min.x), 0);
+		b.y_min = max(int(dom.min.y), 0);
+		b.x_max = min(int(++dom.max.x), w);
+		b.y_max = min(int(++dom.max.y), h);
+
+		if (b.x_min <= b.x_max && b.y_min <= b.y_max)
+			for (size_t row = b.y_min / TILE_HEIGHT; row <= size_t(b.y_max / TILE_HEIGHT); row++)
+				for (size_t column = b.x_min / TILE_WIDTH; column <= size_t(b.x_max / TILE_WIDTH); column++)
+					bins[row * columns + column].push_back(k);
+	}
+
+	// Every pixel of a tile is painted once, by the topmost fill containing it
+	auto render = [&](size_t tile, bool covered[], vector<Span>& spans) {
+		int x_begin = (tile % columns) * TILE_WIDTH, x_end = min(x_begin + TILE_WIDTH - 1, w);
+		int y_begin = (tile / columns) * TILE_HEIGHT, y_end = min(y_begin + TILE_HEIGHT - 1, h);
+
+		fill(covered, covered + TILE_WIDTH * TILE_HEIGHT, false);
+		size_t uncovered = (x_end - x_begin + 1) * (y_end - y_begin + 1);
+
+		const vector<uint32_t>& bin = bins[tile];
+
+		// The topmost (last declared) fills first, the fills below a covered tile being hidden
+		for (auto it = bin.rbegin(); it != bin.rend() && uncovered > 0; it++) {
+			const Fill& fill = _fills[*it];
+			const Bounds& b = bounds[*it];
+
+			int x_min = max(b.x_min, x_begin), x_max = min(b.x_max, x_end);
+			unique_ptr<Scanline> scanline = fill.shape->scanline();
+			uint64_t tested, set;
+
+			for (int y = max(b.y_min, y_begin); y <= min(b.y_max, y_end); y++) {
+				if (profile)
+					profile->begin(*it);
+
+				rasterize(*fill.shape, scanline.get(), spans, *fill.color, im, y, x_min, x_max, covered + (y - y_begin) * TILE_WIDTH, x_begin, tested, set);
+
+				if (profile)
+					profile->end(x_max - x_min + 1, tested, set);
+
+				uncovered -= set;
+			}
+		}
+	};
+
+	// An empty image has no tile whose rendering would complete it
+	if (bins.empty()) {
+		if (progress)
+			progress->complete(_height);
+
+		return;
+	}
+
+	// Tiles left in every row of tiles, and rows of tiles complete from the top one
+	vector<size_t> left(rows, columns);
+	size_t complete = 0;
+	mutex completion;
+
+	// Tiles are distributed dynamically, their costs being uneven, by rows of tiles from the top one such that the image is completed from the top
+	atomic<size_t> next(0);
+
+	auto worker = [&]() {
+		unique_ptr<bool[]> covered = make_unique<bool[]>(TILE_WIDTH * TILE_HEIGHT);
+		vector<Span> spans;
+
+		for (size_t k = next++; k < bins.size(); k = next++) {
+			size_t row = rows - 1 - k / columns;
+
+			render(row * columns + k % columns, covered.get(), spans);
+
+			if (progress) {
+				lock_guard<mutex> lock(completion);
+
+				if (--left[row] == 0) {
+					size_t before = complete;
+					while (complete < rows && left[rows - 1 - complete] == 0)
+						complete++;
+
+					// The top row of tiles may be partial : the complete image rows are those above the incomplete rows of tiles
+					if (complete > before)
+						progress->complete(_height - (rows - complete) * TILE_HEIGHT);
+				}
+			}
+		}
+	};
+
+	if (profile || threads <= 1)
+		worker();
+	else {
+		vector<thread> pool;
+		for (unsigned i = 0; i < min<size_t>(threads, bins.size()); i++)
+			pool.emplace_back(worker);
+
+		for (auto& t : pool)
+			t.join();
+	}
+}
@@ -3,8 +3,12 @@
 
 #include "color.hpp"
 #include "image.hpp"
+#include "profile.hpp"
 #include "shapes.hpp"
 
+#include <condition_variable>
+#include <mutex>
+
 typedef std::shared_ptr<const Color> color_ptr;
 
 struct Fill {
@@ -12,21 +16,68 @@ struct Fill {
 	color_ptr color;
 };
 
+/**
+ * Progress of a rendering : the number of rows of the image which are complete, from the top one, such that they can be consumed (e.g. encoded) alongside the rendering.
+ */
+class Progress {
+	public:
+		Progress() : rows(0) {};
+
+		/**
+		 * Record that the top rows of the image are complete.
+		 */
+		void complete(size_t rows);
+
+		/**
+		 * Wait until more than a number of rows are complete.
+		 *
+		 * @return the number of complete rows
+		 */
+		size_t wait(size_t rows);
+
+	private:
+		std::mutex mutex;
+		std::condition_variable changed;
+		size_t rows;
+};
+
 class Paint {
 	public:
 		Paint() {};
-		Paint(size_t width, size_t height, std::vector<Fill>& fills) : width(width), height(height), fills(fills) {};
+		Paint(size_t width, size_t height, std::vector<Fill>& fills) : _width(width), _height(height), _fills(fills) {};
+
+		size_t width() const { return _width; }
+
+		size_t height() const { return _height; }
+
+		const std::vector<Fill>& fills() const { return _fills; }
+
+		/**
+		 * Scale the paint, canvas included, around the origin.
+		 *
+		 * @return the scaled paint
+		 */
+		Paint scale(double factor) const;
 
 		/**
 		 * Transform the paint into an image.
-		 * 
+		 *
+		 * @param profile if not null, receives the cost of every fill
+		 * @param threads the number of threads rendering the tiles of the image, 1 when profiling
 		 * @return the image
 		 */
-		Image image() const;
+		Image image(Profile* profile = nullptr, unsigned threads = 1) const;
+
+		/**
+		 * Render the paint into an image of its size, the top rows first.
+		 *
+		 * @param progress if not null, receives the rows of the image as they are completed
+		 */
+		void render(Image& im, Profile* profile = nullptr, unsigned threads = 1, Progress* progress = nullptr) const;
 
 	private:
-		size_t width, height;
-		std::vector<Fill> fills;
+		size_t _width, _height;
+		std::vector<Fill> _fills;
 };
 
 #endif
\ No newline at end of file
@@ -1,11 +1,39 @@
 #include "parser.hpp"
+#include "scene.hpp"
 
+#include <cctype>
+#include <cerrno>
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 using namespace std;
 
+/**
+ * Parse a positive integer option value.
+ *
+ * @param str the value, in decimal
+ * @param[out] value the parsed value
+ * @return whether the value is a valid positive integer
+ */
+static bool positive(const char* str, unsigned long& value) {
+	char* end;
+	errno = 0;
+	value = strtoul(str, &end, 10);
+
+	return isdigit(static_cast<unsigned char>(str[0])) && *end == '\0' && errno == 0 && value > 0;
+}
+
+/**
+ * usage: painter FILE [--all] [--compile] [--threads n] [--format ppm|png|qoi] [--profile] [--trace TRACE]
+ *
+ * FILE is either a .paint file or a compiled .paintc file. The image is rendered on --threads threads (by default, one per core), a single one when profiling.
+ * It is written in the --format format (ppm by default), on a background thread encoding its rows as they are rendered : the writing time reported is the one left after the rendering.
+ * With --profile, the has() calls per shape type and the most expensive fills are reported ; with --trace, the stages and fills are written to TRACE as a Chrome trace.
+ */
 int main(int argc, char* argv[]) {
 
 	if (argc < 2) {
@@ -13,77 +41,219 @@ int main(int argc, char* argv[]) {
 		exit(1);
 	}
 
-	// .paint reading
-
 	string filename = argv[1];
-	string line;
-	ifstream file;
+	string basename = filename.substr(0, filename.find_last_of('.'));
+
+	// Recovery mode (--all) : all invalid declarations are reported, not only the first one
+	bool recovering = false;
+
+	// Compilation mode (--compile) : the parsed paint is written as a .paintc file instead of being rendered
+	bool compiling = false;
+
+	// Profiling mode (--profile, --trace) : the cost of every fill is measured
+	bool profiling = false;
+	string tracename;
+
+	unsigned threads = max(thread::hardware_concurrency(), 1u);
+
+	string format = "ppm";
+
+	for (int i = 2; i < argc; i++) {
+		string arg = argv[i];
+		unsigned long value;
+
+		if (arg == "--all")
+			recovering = true;
+		else if (arg == "--compile")
+			compiling = true;
+		else if (arg == "--threads" && i + 1 < argc && positive(argv[i + 1], value) && value <= numeric_limits<unsigned>::max()) {
+			threads = value;
+			i++;
+		}
+		else if (arg == "--format" && i + 1 < argc) {
+			format = argv[++i];
+
+			if (!Encoder::supports(format)) {
+				cerr << "painter: error: invalid format " << format << endl;
+				exit(1);
+			}
+		}
+		else if (arg == "--profile")
+			profiling = true;
+		else if (arg == "--trace" && i + 1 < argc) {
+			tracename = argv[++i];
+			profiling = true;
+		}
+		else {
+			cerr << "painter: error: invalid argument " << arg << endl;
+			exit(1);
+		}
+	}
+
+	Paint paint;
+	Profile profile;
 
 	auto start = chrono::steady_clock::now();
+	auto end = start;
+	double time;
 
-	file.open(filename);
+	if (filename.substr(basename.length()) == ".paintc") {
+		// .paintc loading
 
-	if (!file.is_open()) {
-		cerr << "painter-check: error: " + filename + ": No such file or directory" << endl;
-		exit(1);
-	}
+		try {
+			paint = scene::load(filename);
+		} catch (SceneException& e) {
+			cerr << "painter: error: " << e.what() << endl;
+			exit(1);
+		}
 
-	vector<string> input;
-	while (getline(file, line))
-		input.push_back(line);
+		end = chrono::steady_clock::now();
+		time = chrono::duration <double, milli> (end - start).count();
 
-	file.close();
+		cout << ".paintc file loaded in " << time << " ms" << endl;
 
-	auto end = chrono::steady_clock::now();
-	auto time = chrono::duration <double, milli> (end - start).count();
+		profile.stage("load", start, end);
+	} else {
+		// .paint reading
 
-	cout << ".paint file read in " << time << " ms" << endl;
+		string line;
+		ifstream file;
 
-	// Input parsing
+		file.open(filename);
 
-	Paint paint;
+		if (!file.is_open()) {
+			cerr << "painter-check: error: " + filename + ": No such file or directory" << endl;
+			exit(1);
+		}
 
-	start = chrono::steady_clock::now();
+		vector<string> input;
+		while (getline(file, line))
+			input.push_back(line);
 
-	try {
-		paint = parse::paint(input);
-	} catch (ParseException& e) {
-		cerr << filename + ':' + string(e.what()) << endl;
-		exit(1);
+		file.close();
+
+		end = chrono::steady_clock::now();
+		time = chrono::duration <double, milli> (end - start).count();
+
+		cout << ".paint file read in " << time << " ms" << endl;
+
+		profile.stage("read", start, end);
+
+		// Input parsing
+
+		start = chrono::steady_clock::now();
+
+		if (recovering) {
+			Diagnostics diagnostics;
+			paint = parse::paint(input, diagnostics);
+
+			for (const string& message : diagnostics.kept())
+				cerr << filename + ':' + message << endl;
+
+			if (diagnostics.count() > diagnostics.kept().size())
+				cerr << filename + ": " << diagnostics.count() - diagnostics.kept().size() << " more errors" << endl;
+
+			if (diagnostics.count() > 0)
+				exit(1);
+		} else
+			try {
+				paint = parse::paint(input);
+			} catch (ParseException& e) {
+				cerr << filename + ':' + string(e.what()) << endl;
+				exit(1);
+			}
+
+		end = chrono::steady_clock::now();
+		time = chrono::duration <double, milli> (end - start).count();
+
+		cout << "Input parsed in " << time << " ms" << endl;
+
+		profile.stage("parse", start, end);
 	}
 
-	end = chrono::steady_clock::now();
-	time = chrono::duration <double, milli> (end - start).count();
+	if (compiling) {
+		// .paintc writing
+
+		start = chrono::steady_clock::now();
+
+		try {
+			scene::compile(paint, basename + ".paintc");
+		} catch (SceneException& e) {
+			cerr << "painter: error: " << e.what() << endl;
+			exit(1);
+		}
+
+		end = chrono::steady_clock::now();
+		time = chrono::duration <double, milli> (end - start).count();
+
+		cout << ".paintc file written in " << time << " ms" << endl;
+
+		return 0;
+	}
+
+	// Image computation, and writing alongside
+
+	ofstream output(basename + "." + format, ios::binary);
 
-	cout << "Input parsed in " << time << " ms" << endl;
+	Image im(paint.width(), paint.height());
+	unique_ptr<Encoder> encoder = Encoder::create(format, output, im.width(), im.height());
+	Progress progress;
+	instant first, written;
 
-	// Image computation
+	thread writer([&]() {
+		// Rows are written from the top one
+		for (size_t row = 0; row < im.height(); ) {
+			size_t complete = progress.wait(row);
+
+			if (row == 0)
+				first = chrono::steady_clock::now();
+
+			for (; row < complete; row++)
+				encoder->row(im.row(im.height() - row - 1));
+		}
+
+		encoder->end();
+		output.close();
+
+		written = chrono::steady_clock::now();
+	});
 
 	start = chrono::steady_clock::now();
 
-	Image im = paint.image();
+	Shape::profiling = profiling;
+
+	paint.render(im, profiling ? &profile : nullptr, threads, &progress);
 
 	end = chrono::steady_clock::now();
 	time = chrono::duration <double, milli> (end - start).count();
 
 	cout << "Image computed in " << time << " ms" << endl;
 
-	// .ppm writting
+	profile.stage("render", start, end);
 
-	ofstream output;
+	thread::id writing = writer.get_id();
+	writer.join();
 
-	start = chrono::steady_clock::now();
+	// The writer may finish before the end of the rendering is measured
+	time = max(chrono::duration <double, milli> (written - end).count(), 0.);
 
-	output.open(filename.substr(0, filename.find_last_of('.')) + ".ppm", ios::binary);
+	cout << "." << format << " file written in " << time << " ms" << endl;
 
-	output << im;
+	profile.stage("write", first, written, writing);
 
-	output.close();
+	if (profiling)
+		profile.report(cout);
 
-	end = chrono::steady_clock::now();
-	time = chrono::duration <double, milli> (end - start).count();
+	if (!tracename.empty()) {
+		ofstream trace(tracename);
 
-	cout << ".ppm file written in " << time << " ms" << endl;
+		if (!trace.is_open()) {
+			cerr << "painter: error: " + tracename + ": cannot be written" << endl;
+			exit(1);
+		}
+
+		profile.trace(trace);
+	}
 
 	return 0;
 }
@@ -1,27 +1,11 @@
 #include "parser.hpp"
 
+#include <algorithm>
+
 using namespace std;
 
 /* private */
 
-/**
- * Parse as a name the given string.
- *
- * @throw a ParseException if the given string isn't a valid name
- */
-static void name(const string& str) {
-	if (str.empty())
-		throw ParseException("expected name, got empty");
-
-	auto it = str.begin();
-	if (!isalpha(*it))
-		throw ParseException("invalid first character " + string(1, *it));
-
-	while (++it != str.end())
-		if (!isalnum(*it) && *it != '_')
-			throw ParseException("invalid character " + string(1, *it));
-}
-
 /**
  * Parse as a number the given string.
  *
@@ -212,7 +196,7 @@ static color_ptr colorPointer(Cursor& cursor, const unordered_map<string, color_
  */
 static shape_ptr shapePointer(Cursor& cursor, const unordered_map<string, shape_ptr>& shapes) {
 	string word = cursor.nextWord();
-	name(word);
+	lexer::name(word);
 
 	auto it = shapes.find(word);
 
@@ -230,7 +214,7 @@ static shape_ptr shapePointer(Cursor& cursor, const unordered_map<string, shape_
  */
 static string shapeName(Cursor& cursor, const unordered_map<string, shape_ptr>& shapes) {
 	string word = cursor.nextWord();
-	name(word);
+	lexer::name(word);
 
 	auto it = shapes.find(word);
 
@@ -259,7 +243,7 @@ void parse::size(Cursor& cursor, const std::unordered_map<std::string, shape_ptr
 
 void parse::color(Cursor& cursor, unordered_map<string, color_ptr>& colors, const unordered_map<string, shape_ptr>& shapes) {
 	string word = cursor.nextWord();
-	name(word);
+	lexer::name(word);
 
 	auto it = colors.find(word);
 
@@ -323,12 +307,39 @@ void parse::triangle(Cursor& cursor, unordered_map<string, shape_ptr>& shapes) {
 	shapes[name] = make_shared<Triangle>(Triangle(vertices));
 }
 
+void parse::polygon(Cursor& cursor, unordered_map<string, shape_ptr>& shapes) {
+	string name = shapeName(cursor, shapes);
+	string word = cursor.nextWord();
+
+	Polygon::Rule rule = Polygon::NONZERO;
+
+	if (word == "nonzero" || word == "evenodd") {
+		rule = word == "evenodd" ? Polygon::EVENODD : Polygon::NONZERO;
+		word = cursor.nextWord();
+	}
+
+	if (word != "{")
+		throw ParseException("missing {");
+
+	vector<Point> vertices = {point(cursor, shapes)};
+
+	while (cursor.nextChar() != '}')
+		vertices.push_back(point(cursor, shapes));
+
+	cursor.nextWord();
+
+	if (vertices.size() < 3)
+		throw ParseException("expected at least 3 vertices, got " + to_string(vertices.size()));
+
+	shapes[name] = make_shared<Polygon>(Polygon(vertices, rule));
+}
+
 void parse::shift(Cursor& cursor, unordered_map<string, shape_ptr>& shapes) {
 	string name = shapeName(cursor, shapes);
 	Point P = point(cursor, shapes);
 	shape_ptr shape = shapePointer(cursor, shapes);
 
-	shapes[name] = make_shared<Shift>(Shift(P, shape));
+	shapes[name] = Shift::create(P, shape);
 }
 
 void parse::rotation(Cursor& cursor, unordered_map<string, shape_ptr>& shapes) {
@@ -337,7 +348,7 @@ void parse::rotation(Cursor& cursor, unordered_map<string, shape_ptr>& shapes) {
 	Point P = point(cursor, shapes);
 	shape_ptr shape = shapePointer(cursor, shapes);
 
-	shapes[name] = make_shared<Rotation>(Rotation(theta, P, shape));
+	shapes[name] = Rotation::create(cos(theta), sin(theta), P, shape);
 }
 
 void parse::uniion(Cursor& cursor, unordered_map<string, shape_ptr>& shapes) {
@@ -378,6 +389,7 @@ namespace keyword {
 	const string circle = "circ";
 	const string rectangle = "rect";
 	const string triangle = "tri";
+	const string polygon = "poly";
 	const string shift = "shift";
 	const string rotation = "rot";
 	const string uniion = "union";
@@ -385,27 +397,41 @@ namespace keyword {
 	const string fill = "fill";
 }
 
-Paint parse::paint(const vector<string>& input) {
+/**
+ * @return true if the word starts a declaration (other than the size one), false otherwise
+ */
+static bool isKeyword(const string& word) {
+	static const string keywords[] = {keyword::color, keyword::ellipse, keyword::circle, keyword::rectangle, keyword::triangle, keyword::polygon, keyword::shift, keyword::rotation, keyword::uniion, keyword::difference, keyword::fill};
+	return find(begin(keywords), end(keywords), word) != end(keywords);
+}
+
+/**
+ * Parse as a paint file the given vector of strings.
+ *
+ * @param diagnostics if null, a ParseException is thrown at the first invalid declaration. Otherwise, it receives the error of each invalid declaration and parsing resumes at the next line starting with a keyword, or with a word in its first column.
+ */
+static Paint paint(const vector<string>& input, Diagnostics* diagnostics) {
 	Cursor cursor = Cursor(input);
 
-	size_t width, height;
+	size_t width = 0, height = 0;
 
 	unordered_map<string, color_ptr> colors;
 	unordered_map<string, shape_ptr> shapes;
 	vector<Fill> fills;
-	
-	try {
-		string word = cursor.nextWord();
-
-		if (word == keyword::size)
-			parse::size(cursor, shapes, width, height);
-		else
-			throw ParseException("invalid keyword " + word + ", expected " + keyword::size);
 
-		while (true) {
-			word = cursor.nextWord();
-
-			if (word == keyword::color)
+	string word = cursor.nextWord();
+	bool sized = false;
+
+	while (true) {
+		try {
+			if (!sized) {
+				sized = true;
+
+				if (word == keyword::size)
+					parse::size(cursor, shapes, width, height);
+				else
+					throw ParseException("invalid keyword " + word + ", expected " + keyword::size);
+			} else if (word == keyword::color)
 				parse::color(cursor, colors, shapes);
 			else if (word == keyword::ellipse)
 				parse::ellipse(cursor, shapes);
@@ -415,6 +441,8 @@ Paint parse::paint(const vector<string>& input) {
 				parse::rectangle(cursor, shapes);
 			else if (word == keyword::triangle)
 				parse::triangle(cursor, shapes);
+			else if (word == keyword::polygon)
+				parse::polygon(cursor, shapes);
 			else if (word == keyword::shift)
 				parse::shift(cursor, shapes);
 			else if (word == keyword::rotation)
@@ -429,10 +457,27 @@ Paint parse::paint(const vector<string>& input) {
 				break;
 			else
 				throw ParseException("invalid keyword " + word);
+		} catch (ParseException& e) {
+			string message = cursor.at() + " error: " + string(e.what()) + '\n' + cursor.graphic();
+
+			if (diagnostics == nullptr)
+				throw ParseException(message);
+
+			// Skip the rest of the invalid declaration
+			diagnostics->report(message);
+			cursor.resync(isKeyword);
 		}
-	} catch (ParseException& e) {
-		throw ParseException(cursor.at() + " error: " + string(e.what()) + '\n' + cursor.graphic());
+
+		word = cursor.nextWord();
 	}
 
 	return Paint(width, height, fills);
-}
\ No newline at end of file
+}
+
+Paint parse::paint(const vector<string>& input) {
+	return ::paint(input, nullptr);
+}
+
+Paint parse::paint(const vector<string>& input, Diagnostics& diagnostics) {
+	return ::paint(input, &diagnostics);
+}
@@ -2,19 +2,11 @@
 #define PARSER_H
 
 #include "cursor.hpp"
+#include "lexer.hpp"
 #include "paint.hpp"
 
 #include <unordered_map>
 
-class ParseException: public std::exception {
-	public:
-		explicit ParseException(const std::string& message) : message(message) {};
-		virtual const char* what() const throw() { return message.c_str(); };
-
-	private:
-		std::string message;
-};
-
 namespace parse {
 		/**
 		 * Parse as a size declaration the next tokens given by cursor.
@@ -39,6 +31,7 @@ namespace parse {
 		void circle(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
 		void rectangle(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
 		void triangle(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
+		void polygon(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
 		void shift(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
 		void rotation(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
 		void uniion(Cursor& cursor, std::unordered_map<std::string, shape_ptr>& shapes);
@@ -58,6 +51,14 @@ namespace parse {
 		 * @return the computed paint
 		 */
 		Paint paint(const std::vector<std::string>& input);
+
+		/**
+		 * Parse as a paint file the given vector of strings, recovering from invalid declarations : parsing resumes at the next line starting with a keyword, or with a word in its first column.
+		 *
+		 * @param diagnostics the container receiving the error of each invalid declaration
+		 * @return the paint of the valid declarations
+		 */
+		Paint paint(const std::vector<std::string>& input, Diagnostics& diagnostics);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+	const char* NAMES[SHAPE_TYPES] = {"ellipse", "circle", "polygon", "rectangle", "triangle", "shift", "rotation", "union", "difference", "scale"};
+
+	/**
+	 * @return the total number of has() calls of a fill
+	 */
+	uint64_t total(const Profile::FillProfile& fill) {
+		uint64_t n = 0;
+		for (size_t t = 0; t < SHAPE_TYPES; t++)
+			n += fill.calls[t];
+
+		return n;
+	}
+}
+
+int Profile::tid(thread::id thread) {
+	auto it = find(threads.begin(), threads.end(), thread);
+
+	if (it == threads.end())
+		it = threads.insert(it, thread);
+
+	return it - threads.begin() + 1;
+}
+
+void Profile::stage(const string& name, instant start, instant end, thread::id thread) {
+	stages.push_back({name, this->tid(thread), this->since(start), this->since(end) - this->since(start)});
+}
+
+void Profile::begin(size_t index) {
+	copy(Shape::calls, Shape::calls + SHAPE_TYPES, calls);
+
+	while (fills.size() <= index)
+		fills.push_back({fills.size(), -1, 0, 0, 0, 0, {}});
+
+	current = index;
+	started = chrono::steady_clock::now();
+}
+
+void Profile::end(uint64_t pixels, uint64_t tested, uint64_t set) {
+	instant now = chrono::steady_clock::now();
+	FillProfile& fill = fills[current];
+	double start = this->since(started), duration = this->since(now) - start;
+
+	if (fill.start < 0)
+		fill.start = start;
+
+	fill.duration += duration;
+	fill.pixels += pixels;
+	fill.tested += tested;
+	fill.set += set;
+
+	// A part following one of the same fill on the same thread extends it
+	int thread = this->tid(this_thread::get_id());
+
+	if (parts.empty() || parts.back().index != current || parts.back().tid != thread)
+		parts.push_back({current, thread, start, 0, 0, 0, 0, {}});
+
+	Part& part = parts.back();
+	part.duration += duration;
+	part.pixels += pixels;
+	part.tested += tested;
+	part.set += set;
+
+	for (size_t t = 0; t < SHAPE_TYPES; t++) {
+		fill.calls[t] += Shape::calls[t] - calls[t];
+		part.calls[t] += Shape::calls[t] - calls[t];
+	}
+}
+
+void Profile::report(ostream& out, size_t top) const {
+	uint64_t calls[SHAPE_TYPES] = {}, n = 0;
+
+	for (const FillProfile& fill : fills)
+		for (size_t t = 0; t < SHAPE_TYPES; t++)
+			calls[t] += fill.calls[t];
+
+	out << "has() calls per shape type:" << endl;
+
+	for (size_t t = 0; t < SHAPE_TYPES; t++)
+		if (calls[t] > 0) {
+			out << "  " << left << setw(12) << NAMES[t] << right << setw(14) << calls[t] << endl;
+			n += calls[t];
+		}
+
+	out << "  " << left << setw(12) << "total" << right << setw(14) << n << endl;
+
+	vector<const FillProfile*> order;
+	for (const FillProfile& fill : fills)
+		if (fill.start >= 0)
+			order.push_back(&fill);
+
+	sort(order.begin(), order.end(), [](const FillProfile* a, const FillProfile* b) { return a->duration > b->duration; });
+
+	if (order.size() > top)
+		order.resize(top);
+
+	out << "Most expensive fills:" << endl;
+	out << setw(8) << "fill" << setw(12) << "time (ms)" << setw(12) << "pixels" << setw(12) << "tested" << setw(12) << "set" << setw(14) << "has() calls" << endl;
+
+	for (const FillProfile* fill : order)
+		out << setw(8) << fill->index << setw(12) << fixed << setprecision(3) << fill->duration / 1000 << defaultfloat
+			<< setw(12) << fill->pixels << setw(12) << fill->tested << setw(12) << fill->set << setw(14) << total(*fill) << endl;
+}
+
+void Profile::trace(ostream& out) const {
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+	bool first = true;
+
+	auto event = [&](const string& name, const string& category, int tid, double start, double duration) {
+		out << (first ? "\n" : ",\n");
+		out << "  {\"name\": \"" << name << "\", \"cat\": \"" << category << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid;
+		out << ", \"ts\": " << fixed << setprecision(3) << start << ", \"dur\": " << duration << defaultfloat;
+		first = false;
+	};
+
+	for (const Stage& stage : stages) {
+		event(stage.name, "stage", stage.tid, stage.start, stage.duration);
+		out << "}";
+	}
+
+	for (const Part& part : parts) {
+		event("fill " + to_string(part.index), "fill", part.tid, part.start, part.duration);
+
+		out << ", \"args\": {\"pixels\": " << part.pixels << ", \"tested\": " << part.tested << ", \"set\": " << part.set;
+		for (size_t t = 0; t < SHAPE_TYPES; t++)
+			if (part.calls[t] > 0)
+				out << ", \"" << NAMES[t] << "\": " << part.calls[t];
+		out << "}}";
+	}
+
+	out << "\n]}" << endl;
+}
@@ -0,0 +1,109 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "shapes.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+typedef std::chrono::steady_clock::time_point instant;
+
+/**
+ * Measures of a run of painter : the duration of every stage, and the cost of every fill of the rendering.
+ *
+ * The rasterization of a fill may be measured in several parts (e.g. one per row) : its measures are the sums of those of its parts, its start the one of its first part.
+ * The parts are also kept, those measured one after the other on a thread being merged, to be traced on the thread which measured them.
+ */
+class Profile {
+	public:
+		struct Stage {
+			std::string name;
+			int tid;
+			double start, duration;
+		};
+
+		struct FillProfile {
+			size_t index;
+
+			// Start of the first part (negative if the fill was never rasterized) and total duration, in µs
+			double start, duration;
+
+			// Pixels of the domain of the fill which were visited, pixels evaluated (the others being skipped), pixels painted
+			uint64_t pixels, tested, set;
+
+			// Numbers of calls to has() per shape type
+			uint64_t calls[SHAPE_TYPES];
+		};
+
+		/**
+		 * Consecutive parts of the rasterization of a fill on a thread : the sum of their measures, from the start of the first one.
+		 */
+		struct Part {
+			size_t index;
+			int tid;
+			double start, duration;
+			uint64_t pixels, tested, set;
+			uint64_t calls[SHAPE_TYPES];
+		};
+
+		Profile() : origin(std::chrono::steady_clock::now()) {};
+
+		/**
+		 * Record a stage of the run.
+		 *
+		 * @param thread the thread which ran the stage
+		 */
+		void stage(const std::string& name, instant start, instant end, std::thread::id thread = std::this_thread::get_id());
+
+		/**
+		 * Start measuring a part of the rasterization of a fill : has() calls are counted from now on.
+		 *
+		 * @param index the index of the fill in its paint
+		 */
+		void begin(size_t index);
+
+		/**
+		 * Finish measuring the part begun last.
+		 *
+		 * @param pixels, tested, set the numbers of pixels of the part (see FillProfile)
+		 */
+		void end(uint64_t pixels, uint64_t tested, uint64_t set);
+
+		/**
+		 * Write a summary : has() calls per shape type, and the most expensive fills.
+		 *
+		 * @param top the number of fills reported
+		 */
+		void report(std::ostream& out, size_t top = 10) const;
+
+		/**
+		 * Write the stages and the parts of the fills as a Chrome trace (JSON), to be opened in chrome://tracing or Perfetto, on the threads which ran them.
+		 */
+		void trace(std::ostream& out) const;
+
+	private:
+		instant origin;
+		instant started;
+		size_t current;
+		uint64_t calls[SHAPE_TYPES];
+
+		std::vector<Stage> stages;
+		std::vector<FillProfile> fills;
+		std::vector<Part> parts;
+
+		// Threads seen, their trace ids being their positions from 1
+		std::vector<std::thread::id> threads;
+
+		/**
+		 * @return the trace id of a thread
+		 */
+		int tid(std::thread::id thread);
+
+		/**
+		 * @return the number of microseconds between the creation of the profile and an instant
+		 */
+		double since(instant t) const { return std::chrono::duration <double, std::micro> (t - origin).count(); };
+};
+
+#endif
@@ -0,0 +1,350 @@
+#include "scene.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* shapes */
+
+uint32_t Ellipse::compile(SceneWriter& scene) const {
+	// The orientation is only written if the ellipse is rotated
+	if (cos_theta == 1 && sin_theta == 0)
+		return scene.add(this, ELLIPSE, {center.x, center.y, a, b});
+
+	return scene.add(this, ELLIPSE, {center.x, center.y, a, b, cos_theta, sin_theta});
+}
+
+uint32_t Circle::compile(SceneWriter& scene) const {
+	return scene.add(this, CIRCLE, {center.x, center.y, a});
+}
+
+uint32_t Polygon::compile(SceneWriter& scene) const {
+	vector<double> values = {double(rule)};
+	for (const Point& P : vertices) {
+		values.push_back(P.x);
+		values.push_back(P.y);
+	}
+
+	return scene.add(this, POLYGON, values);
+}
+
+uint32_t Rectangle::compile(SceneWriter& scene) const {
+	return scene.add(this, RECTANGLE, {center.x, center.y, 2 * width, 2 * height});
+}
+
+uint32_t Triangle::compile(SceneWriter& scene) const {
+	return scene.add(this, TRIANGLE, {vertices[0].x, vertices[0].y, vertices[1].x, vertices[1].y, vertices[2].x, vertices[2].y});
+}
+
+uint32_t Shift::compile(SceneWriter& scene) const {
+	return scene.add(this, SHIFT, {center.x, center.y}, {shape});
+}
+
+uint32_t Rotation::compile(SceneWriter& scene) const {
+	return scene.add(this, ROTATION, {cos_theta, sin_theta, center.x, center.y}, {shape});
+}
+
+uint32_t Scale::compile(SceneWriter& scene) const {
+	return scene.add(this, SCALE, {factor}, {shape});
+}
+
+uint32_t Union::compile(SceneWriter& scene) const {
+	return scene.add(this, UNION, {}, set);
+}
+
+uint32_t Difference::compile(SceneWriter& scene) const {
+	return scene.add(this, DIFFERENCE, {}, {in, out});
+}
+
+/* writer */
+
+uint32_t SceneWriter::add(const Shape* shape, ShapeType type, const vector<double>& values, const vector<shape_ptr>& children) {
+	auto it = indices.find(shape);
+
+	if (it != indices.end())
+		return it->second;
+
+	// Shared shapes are written once, before the shapes depending on them
+	vector<uint32_t> dependencies;
+	for (const shape_ptr& child : children)
+		dependencies.push_back(child->compile(*this));
+
+	Record record = {type, (uint32_t) this->values.size(), (uint32_t) values.size(), (uint32_t) this->children.size(), (uint32_t) dependencies.size()};
+
+	this->values.insert(this->values.end(), values.begin(), values.end());
+	this->children.insert(this->children.end(), dependencies.begin(), dependencies.end());
+	records.push_back(record);
+
+	return indices[shape] = records.size() - 1;
+}
+
+/* file format */
+
+namespace {
+	const char MAGIC[8] = {'P', 'A', 'I', 'N', 'T', 'C', '\0', '\0'};
+	const uint32_t VERSION = 1;
+
+	// Largest deviation from 1 of cos² + sin² for an orientation
+	const double UNIT_TOLERANCE = 1e-9;
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t shapes, values, children, colors, fills;
+		uint64_t width, height;
+	};
+
+	struct ColorRecord {
+		uint8_t r, g, b, padding;
+	};
+
+	struct FillRecord {
+		uint32_t shape, color;
+	};
+
+	/**
+	 * @return true if the numbers of values and of children of a shape record match its type, false otherwise
+	 */
+	bool valid(const SceneWriter::Record& record) {
+		switch (record.type) {
+			case ELLIPSE:
+				return (record.value_count == 4 || record.value_count == 6) && record.child_count == 0;
+			case RECTANGLE:
+				return record.value_count == 4 && record.child_count == 0;
+			case CIRCLE:
+				return record.value_count == 3 && record.child_count == 0;
+			case POLYGON:
+				return record.value_count >= 7 && record.value_count % 2 == 1 && record.child_count == 0;
+			case TRIANGLE:
+				return record.value_count == 6 && record.child_count == 0;
+			case SHIFT:
+				return record.value_count == 2 && record.child_count == 1;
+			case ROTATION:
+				return record.value_count == 4 && record.child_count == 1;
+			case UNION:
+				return record.value_count == 0 && record.child_count > 0;
+			case DIFFERENCE:
+				return record.value_count == 0 && record.child_count == 2;
+			case SCALE:
+				return record.value_count == 1 && record.child_count == 1;
+			default:
+				return false;
+		}
+	}
+
+	/**
+	 * @return true if the values of a shape record are finite, its lengths non-negative and its orientations made of a cosine and a sine, false otherwise
+	 */
+	bool consistent(const SceneWriter::Record& record, const double* v) {
+		for (uint32_t j = 0; j < record.value_count; j++)
+			if (!isfinite(v[j]))
+				return false;
+
+		auto unit = [](double cos_theta, double sin_theta) { return abs(cos_theta * cos_theta + sin_theta * sin_theta - 1) <= UNIT_TOLERANCE; };
+
+		switch (record.type) {
+			case ELLIPSE:
+				return v[2] >= 0 && v[3] >= 0 && (record.value_count == 4 || unit(v[4], v[5]));
+			case RECTANGLE:
+				return v[2] >= 0 && v[3] >= 0;
+			case CIRCLE:
+				return v[2] >= 0;
+			case POLYGON:
+				return v[0] == Polygon::NONZERO || v[0] == Polygon::EVENODD;
+			case ROTATION:
+				return unit(v[0], v[1]);
+			case SCALE:
+				return v[0] > 0;
+			default:
+				return true;
+		}
+	}
+
+	/**
+	 * Write the elements of a container as raw bytes.
+	 */
+	template <typename T>
+	void write(ofstream& out, const vector<T>& elements) {
+		out.write(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(T));
+	}
+}
+
+void scene::compile(const Paint& paint, const string& filename) {
+	SceneWriter writer;
+	vector<ColorRecord> colors;
+	vector<FillRecord> fills;
+	unordered_map<const Color*, uint32_t> indices;
+
+	for (const Fill& fill : paint.fills()) {
+		auto it = indices.find(fill.color.get());
+
+		if (it == indices.end()) {
+			it = indices.emplace(fill.color.get(), colors.size()).first;
+			colors.push_back({fill.color->r, fill.color->g, fill.color->b, 0});
+		}
+
+		fills.push_back({fill.shape->compile(writer), it->second});
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.shapes = writer.records.size();
+	header.values = writer.values.size();
+	header.children = writer.children.size();
+	header.colors = colors.size();
+	header.fills = fills.size();
+	header.width = paint.width();
+	header.height = paint.height();
+
+	ofstream out(filename, ios::binary);
+
+	if (!out.is_open())
+		throw SceneException(filename + ": cannot be written");
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	write(out, writer.values);
+	write(out, writer.records);
+	write(out, writer.children);
+	write(out, colors);
+	write(out, fills);
+
+	if (!out)
+		throw SceneException(filename + ": cannot be written");
+}
+
+Paint scene::load(const string& filename) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw SceneException(filename + ": No such file or directory");
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(Header)) {
+		close(fd);
+		throw SceneException(filename + ": invalid compiled scene");
+	}
+
+	size_t size = st.st_size;
+	void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
+		throw SceneException(filename + ": cannot be mapped");
+
+	const char* data = static_cast<const char*>(map);
+	const Header& header = *reinterpret_cast<const Header*>(data);
+
+	size_t expected = sizeof(Header)
+		+ header.values * sizeof(double)
+		+ header.shapes * sizeof(SceneWriter::Record)
+		+ header.children * sizeof(uint32_t)
+		+ header.colors * sizeof(ColorRecord)
+		+ header.fills * sizeof(FillRecord);
+
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || size != expected) {
+		munmap(map, size);
+		throw SceneException(filename + ": invalid compiled scene");
+	}
+
+	const double* values = reinterpret_cast<const double*>(data + sizeof(Header));
+	const SceneWriter::Record* records = reinterpret_cast<const SceneWriter::Record*>(values + header.values);
+	const uint32_t* children = reinterpret_cast<const uint32_t*>(records + header.shapes);
+	const ColorRecord* colors = reinterpret_cast<const ColorRecord*>(children + header.children);
+	const FillRecord* fills = reinterpret_cast<const FillRecord*>(colors + header.colors);
+
+	vector<shape_ptr> shapes;
+	shapes.reserve(header.shapes);
+
+	try {
+		for (uint32_t i = 0; i < header.shapes; i++) {
+			const SceneWriter::Record& record = records[i];
+
+			if (!valid(record) || size_t(record.value_first) + record.value_count > header.values || size_t(record.child_first) + record.child_count > header.children)
+				throw SceneException(filename + ": invalid shape record " + to_string(i));
+
+			const double* v = values + record.value_first;
+
+			if (!consistent(record, v))
+				throw SceneException(filename + ": invalid shape record " + to_string(i));
+			vector<shape_ptr> set;
+
+			for (uint32_t j = record.child_first; j < record.child_first + record.child_count; j++) {
+				if (children[j] >= i)
+					throw SceneException(filename + ": invalid shape dependency " + to_string(children[j]));
+
+				set.push_back(shapes[children[j]]);
+			}
+
+			switch (record.type) {
+				case ELLIPSE:
+					if (record.value_count == 6)
+						shapes.push_back(make_shared<Ellipse>(Ellipse(Point(v[0], v[1]), v[2], v[3], v[4], v[5])));
+					else
+						shapes.push_back(make_shared<Ellipse>(Ellipse(Point(v[0], v[1]), v[2], v[3])));
+					break;
+				case CIRCLE:
+					shapes.push_back(make_shared<Circle>(Circle(Point(v[0], v[1]), v[2])));
+					break;
+				case POLYGON: {
+					vector<Point> vertices;
+					for (uint32_t j = 1; j < record.value_count; j += 2)
+						vertices.push_back(Point(v[j], v[j + 1]));
+
+					shapes.push_back(make_shared<Polygon>(Polygon(vertices, Polygon::Rule(v[0]))));
+					break;
+				}
+				case RECTANGLE:
+					shapes.push_back(make_shared<Rectangle>(Rectangle(Point(v[0], v[1]), v[2], v[3])));
+					break;
+				case TRIANGLE:
+					shapes.push_back(make_shared<Triangle>(Triangle({Point(v[0], v[1]), Point(v[2], v[3]), Point(v[4], v[5])})));
+					break;
+				case SHIFT:
+					shapes.push_back(Shift::create(Point(v[0], v[1]), set[0]));
+					break;
+				case ROTATION:
+					shapes.push_back(Rotation::create(v[0], v[1], Point(v[2], v[3]), set[0]));
+					break;
+				case UNION:
+					shapes.push_back(make_shared<Union>(Union(set)));
+					break;
+				case DIFFERENCE:
+					shapes.push_back(make_shared<Difference>(Difference(set[0], set[1])));
+					break;
+				case SCALE:
+					shapes.push_back(Scale::create(v[0], set[0]));
+					break;
+			}
+		}
+	} catch (SceneException& e) {
+		munmap(map, size);
+		throw;
+	}
+
+	vector<color_ptr> palette;
+	for (uint32_t i = 0; i < header.colors; i++)
+		palette.push_back(make_shared<Color>(Color(colors[i].r, colors[i].g, colors[i].b)));
+
+	vector<Fill> paintFills;
+	for (uint32_t i = 0; i < header.fills; i++) {
+		if (fills[i].shape >= header.shapes || fills[i].color >= header.colors) {
+			munmap(map, size);
+			throw SceneException(filename + ": invalid fill " + to_string(i));
+		}
+
+		paintFills.push_back({shapes[fills[i].shape], palette[fills[i].color]});
+	}
+
+	size_t width = header.width, height = header.height;
+
+	munmap(map, size);
+
+	return Paint(width, height, paintFills);
+}
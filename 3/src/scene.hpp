@@ -0,0 +1,77 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "paint.hpp"
+
+#include <unordered_map>
+
+/**
+ * Compiled scene (.paintc) : the resolved shapes, colors and fills of a paint, in a binary format which is loaded without parsing.
+ *
+ * Layout, in native byte order, every section being aligned on its element size :
+ *   - a header (magic, version, section sizes, width and height) ;
+ *   - the values (doubles) of all shapes ;
+ *   - the shape records (type, values and children ranges), each shape after the shapes it depends on ;
+ *   - the children (shape indices) of all shapes ;
+ *   - the colors (r, g, b, padding) ;
+ *   - the fills (shape and color indices).
+ */
+
+class SceneException: public std::exception {
+	public:
+		explicit SceneException(const std::string& message) : message(message) {};
+		virtual const char* what() const throw() { return message.c_str(); };
+
+	private:
+		std::string message;
+};
+
+namespace scene {
+	/**
+	 * Write a paint as a compiled scene.
+	 *
+	 * @throw a SceneException if the file cannot be written
+	 */
+	void compile(const Paint& paint, const std::string& filename);
+
+	/**
+	 * Load a compiled scene.
+	 *
+	 * @throw a SceneException if the file cannot be read or isn't a valid compiled scene
+	 * @return the paint of the scene
+	 */
+	Paint load(const std::string& filename);
+};
+
+/**
+ * Builder of the shape section of a compiled scene.
+ */
+class SceneWriter {
+	public:
+		struct Record {
+			uint32_t type;
+			uint32_t value_first, value_count;
+			uint32_t child_first, child_count;
+		};
+
+		/**
+		 * Append a shape, unless already appended, after the shapes it depends on.
+		 *
+		 * @param shape the shape
+		 * @param type the type of the shape
+		 * @param values the parameters of the shape
+		 * @param children the shapes it depends on
+		 * @return the index of the shape
+		 */
+		uint32_t add(const Shape* shape, ShapeType type, const std::vector<double>& values, const std::vector<shape_ptr>& children = {});
+
+	private:
+		friend void scene::compile(const Paint& paint, const std::string& filename);
+
+		std::vector<double> values;
+		std::vector<Record> records;
+		std::vector<uint32_t> children;
+		std::unordered_map<const Shape*, uint32_t> indices;
+};
+
+#endif
@@ -4,6 +4,9 @@
 
 using namespace std;
 
+bool Shape::profiling = false;
+uint64_t Shape::calls[SHAPE_TYPES] = {};
+
 Point& Point::operator +=(const Point& P) {
 	x += P.x;
 	y += P.y;
@@ -28,6 +31,49 @@ Point& Point::operator /=(double n) {
 	return *this;
 }
 
+namespace {
+	/**
+	 * Append to spans the pixels of a row between two bounds of the abscissas within a shape.
+	 * The bounds being rounded, the pixels at their ends are decided by the test of the shape instead, such that both agree.
+	 *
+	 * @param inside the test of the shape at an abscissa of the row
+	 */
+	template <typename Test>
+	void snap(double begin, double end, const Test& inside, vector<Span>& spans) {
+		// First and last pixels which center is within the bounds
+		double first = ceil(begin - 0.5), last = floor(end - 0.5);
+
+		if (first > last + 1)
+			return;
+
+		while (inside(first - 0.5))
+			first--;
+		while (inside(last + 1.5))
+			last++;
+		while (first <= last && !inside(first + 0.5))
+			first++;
+		while (last >= first && !inside(last + 0.5))
+			last--;
+
+		// From the center of the first pixel to (just after) the center of the last one
+		if (first <= last)
+			spans.push_back({first + 0.5, nextafter(last + 0.5, INFINITY)});
+	}
+}
+
+Ellipse::Ellipse(Point center, double a, double b, double cos_theta, double sin_theta) : a(a), b(b), a2(a * a), b2(b * b), cos_theta(cos_theta), sin_theta(sin_theta) {
+	assert(a >= 0);
+	assert(b >= 0);
+
+	this->center = center;
+
+	// x² b² + y² a² <= a² b² in the frame of the axes, rotated back
+	xx = cos_theta * cos_theta * b2 + sin_theta * sin_theta * a2;
+	xy = 2 * cos_theta * sin_theta * (b2 - a2);
+	yy = sin_theta * sin_theta * b2 + cos_theta * cos_theta * a2;
+	limit = a2 * b2;
+}
+
 Point Ellipse::point(const string& name) const {
 	Point P;
 
@@ -59,10 +105,72 @@ Point Ellipse::point(const string& name) const {
 	return this->absolute(P);
 }
 
-inline bool Ellipse::has(const Point& P) const {
+double Ellipse::distance(const Point& P) const {
+	if (a == 0 || b == 0)
+		return 0;
+
 	Point Q = this->relative(P);
 
-	return pow(Q.x, 2) * b2 + pow(Q.y, 2) * a2 <= a2 * b2;
+	// The boundary is the unit level set of a function whose gradient norm is at most 1 / min(a, b)
+	return (Point(Q.x / a, Q.y / b).norm() - 1) * min(a, b);
+}
+
+Domain Ellipse::domain() const {
+	Point extent(sqrt(a2 * cos_theta * cos_theta + b2 * sin_theta * sin_theta), sqrt(a2 * sin_theta * sin_theta + b2 * cos_theta * cos_theta));
+
+	return {center - extent, center + extent};
+}
+
+/**
+ * Rasterization of an ellipse : on every row, the quadratic form is a trinomial in dx which roots bound the abscissas.
+ */
+class Ellipse::Chords : public Scanline {
+	public:
+		Chords(const Ellipse& ellipse) : ellipse(ellipse) {}
+
+		void spans(double y, vector<Span>& spans) {
+			spans.clear();
+
+			const Ellipse& e = ellipse;
+			double dy = y - e.center.y;
+
+			// xx dx² + p dx + q <= 0 : if the discriminant is negative, the row misses the ellipse up to rounding, and only the pixels at the vertex of the trinomial are tested
+			double p = e.xy * dy, q = e.yy * dy * dy - e.limit;
+			double discriminant = p * p - 4 * e.xx * q;
+			double h = discriminant > 0 ? sqrt(discriminant) : 0;
+
+			double begin = e.center.x + (-p - h) / (2 * e.xx), end = e.center.x + (-p + h) / (2 * e.xx);
+
+			snap(begin, end, [&](double x) { return e.inside(Point(x, y)); }, spans);
+		}
+
+	private:
+		const Ellipse& ellipse;
+};
+
+unique_ptr<Scanline> Ellipse::scanline() const {
+	// A flat ellipse has no interior
+	if (!(limit > 0))
+		return nullptr;
+
+	return make_unique<Chords>(*this);
+}
+
+shape_ptr Ellipse::moved(double cos_theta, double sin_theta, const Point& P, const Point& shift) const {
+	Point orientation = Point(this->cos_theta, this->sin_theta).rotation(cos_theta, sin_theta);
+
+	return make_shared<Ellipse>(Ellipse(center.rotation(cos_theta, sin_theta, P) + shift, a, b, orientation.x, orientation.y));
+}
+
+shape_ptr Ellipse::scaled(double factor) const {
+	return make_shared<Ellipse>(Ellipse(center * factor, a * factor, b * factor, cos_theta, sin_theta));
+}
+
+Circle::Circle(Point center, double radius, double cos_theta, double sin_theta) : Ellipse(center, radius, radius, cos_theta, sin_theta) {
+	// dx² + dy² <= r², whatever the orientation
+	xx = yy = 1;
+	xy = 0;
+	limit = a2;
 }
 
 Point Circle::point(const string& name) const {
@@ -72,19 +180,155 @@ Point Circle::point(const string& name) const {
 	return Ellipse::point(name);
 }
 
-inline bool Circle::has(const Point& P) const {
-	Point Q = this->relative(P);
+shape_ptr Circle::moved(double cos_theta, double sin_theta, const Point& P, const Point& shift) const {
+	Point orientation = Point(this->cos_theta, this->sin_theta).rotation(cos_theta, sin_theta);
+
+	return make_shared<Circle>(Circle(center.rotation(cos_theta, sin_theta, P) + shift, a, orientation.x, orientation.y));
+}
 
-	return pow(Q.x, 2) + pow(Q.y, 2) <= a2;
+shape_ptr Circle::scaled(double factor) const {
+	return make_shared<Circle>(Circle(center * factor, a * factor, cos_theta, sin_theta));
 }
 
-Polygon::Polygon(const std::vector<Point>& vertices) : n(vertices.size()), vertices(vertices) {
+Polygon::Polygon(const std::vector<Point>& vertices, Rule rule) : n(vertices.size()), vertices(vertices), rule(rule) {
 	for (auto it = vertices.begin(); it != vertices.end(); it++)
 		center += *it;
 
 	center /= n;
 }
 
+Point Polygon::point(const string& name) const {
+	if (name == "c")
+		return center;
+
+	// vk is the kth vertex
+	if (name.length() > 1 && name[0] == 'v' && all_of(name.begin() + 1, name.end(), ::isdigit) && name.length() < 10) {
+		size_t k = stoul(name.substr(1));
+
+		if (k < n)
+			return vertices[k];
+	}
+
+	throw NamedPointException("invalid named point " + name);
+}
+
+bool Polygon::inside(const Point& P) const {
+	unsigned crossings = 0;
+	int winding = 0;
+
+	// Edges crossing the horizontal ray from P to the right, each edge [a, b] including a and excluding b
+	for (size_t i = 0; i < n; i++) {
+		const Point& a = vertices[i];
+		const Point& b = vertices[(i + 1) % n];
+
+		if ((a.y > P.y) != (b.y > P.y) && P.x < a.x + (P.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+			crossings++;
+			winding += b.y > a.y ? 1 : -1;
+		}
+	}
+
+	return rule == EVENODD ? crossings % 2 == 1 : winding != 0;
+}
+
+double Polygon::distance(const Point& P) const {
+	double d = this->segment(P, n - 1, 0);
+
+	for (size_t i = 0; i + 1 < n; i++)
+		d = min(d, this->segment(P, i, i + 1));
+
+	return this->inside(P) ? -d : d;
+}
+
+namespace {
+	/**
+	 * Active edge table : the edges of a polygon sorted by lowest ordinate, the edges crossing the current row being active.
+	 */
+	class EdgeTable : public Scanline {
+		public:
+			EdgeTable(const vector<Point>& vertices, Polygon::Rule rule) : next(0), rule(rule) {
+				for (size_t i = 0; i < vertices.size(); i++) {
+					const Point& a = vertices[i];
+					const Point& b = vertices[(i + 1) % vertices.size()];
+
+					// Horizontal edges never cross a row
+					if (a.y != b.y)
+						edges.push_back({min(a.y, b.y), max(a.y, b.y), a, b, b.y > a.y ? 1 : -1});
+				}
+
+				sort(edges.begin(), edges.end(), [](const Edge& e, const Edge& f) { return e.y_min < f.y_min; });
+			}
+
+			void spans(double y, vector<Span>& spans) {
+				spans.clear();
+
+				while (next < edges.size() && edges[next].y_min <= y)
+					active.push_back(&edges[next++]);
+
+				active.erase(remove_if(active.begin(), active.end(), [y](const Edge* e) { return e->y_max <= y; }), active.end());
+
+				// The abscissas are computed as in Polygon::inside(), such that both agree
+				crossings.clear();
+				for (const Edge* e : active)
+					crossings.push_back({e->a.x + (y - e->a.y) * (e->b.x - e->a.x) / (e->b.y - e->a.y), e->direction});
+
+				sort(crossings.begin(), crossings.end());
+
+				int winding = 0;
+
+				for (size_t k = 0; k < crossings.size(); k++) {
+					bool within = rule == Polygon::EVENODD ? k % 2 == 1 : winding != 0;
+					winding += crossings[k].second;
+
+					if (!within)
+						continue;
+
+					double begin = crossings[k - 1].first, end = crossings[k].first;
+
+					if (begin == end)
+						continue;
+
+					if (!spans.empty() && spans.back().end == begin)
+						spans.back().end = end;
+					else
+						spans.push_back({begin, end});
+				}
+			}
+
+		private:
+			struct Edge {
+				double y_min, y_max;
+				Point a, b;
+				int direction;
+			};
+
+			vector<Edge> edges;
+			size_t next;
+			vector<const Edge*> active;
+			vector<pair<double, int>> crossings;
+			Polygon::Rule rule;
+	};
+}
+
+unique_ptr<Scanline> Polygon::scanline() const {
+	return make_unique<EdgeTable>(vertices, rule);
+}
+
+shape_ptr Polygon::scaled(double factor) const {
+	vector<Point> scaled;
+	for (const Point& P : vertices)
+		scaled.push_back(P * factor);
+
+	return make_shared<Polygon>(Polygon(scaled, rule));
+}
+
+double Polygon::segment(const Point& P, size_t i, size_t j) const {
+	Point u = vertices[j] - vertices[i], v = P - vertices[i];
+	double length = Point::dot(u, u);
+	double t = length > 0 ? min(max(Point::dot(u, v) / length, 0.), 1.) : 0;
+
+	return (v - u * t).norm();
+}
+
 Domain Polygon::domain() const {
 	Domain dom = {vertices[0], vertices[0]};
 
@@ -142,11 +386,43 @@ Point Rectangle::point(const string& name) const {
 }
 
 inline bool Rectangle::has(const Point& P) const {
+	count(RECTANGLE);
+
 	Point Q = this->relative(P);
 
 	return abs(Q.x) <= width && abs(Q.y) <= height;
 }
 
+double Rectangle::distance(const Point& P) const {
+	Point Q = this->relative(P);
+	double dx = abs(Q.x) - width, dy = abs(Q.y) - height;
+
+	if (dx <= 0 && dy <= 0)
+		return max(dx, dy);
+
+	return Point(max(dx, 0.), max(dy, 0.)).norm();
+}
+
+shape_ptr Rectangle::scaled(double factor) const {
+	return make_shared<Rectangle>(Rectangle(center * factor, 2 * width * factor, 2 * height * factor));
+}
+
+Triangle::Triangle(const vector<Point>& vertices) : Polygon(vertices) {
+	double area = Point::cross(vertices[1] - vertices[0], vertices[2] - vertices[0]);
+	flat = area == 0;
+
+	// Oriented such that the interior is on the non-negative side of every edge
+	double orientation = area < 0 ? -1 : 1;
+
+	for (size_t i = 0; i < 3; i++) {
+		const Point& P = vertices[i];
+		const Point& Q = vertices[(i + 1) % 3];
+
+		a[i] = orientation * (P.y - Q.y);
+		b[i] = orientation * (Q.x - P.x);
+	}
+}
+
 Point Triangle::point(const string& name) const {
 	if (name == "c")
 		return center;
@@ -167,26 +443,83 @@ Point Triangle::point(const string& name) const {
 }
 
 bool Triangle::has(const Point& P) const {
-	double cross;
-	bool b[n];
+	count(TRIANGLE);
+	return this->inside(P);
+}
 
-	Point vect[] = {P - vertices[0], P - vertices[1], P - vertices[2]};
+double Triangle::distance(const Point& P) const {
+	double d = min(min(this->segment(P, 0, 1), this->segment(P, 1, 2)), this->segment(P, 2, 0));
 
-	for (size_t i = 0; i < n; i++) {
-		cross = Point::cross(vect[i], vect[(i + 1) % n]);
-		if (cross == 0)
-			if (vect[i].x * vect[(i + 1) % n].x <= 0)
-				return true;
-			else
-				return false;
-		else
-			b[i] = cross > 0;
-
-		if (i > 0 && b[i - 1] != b[i])
-			return false;
-	}
+	return this->inside(P) ? -d : d;
+}
+
+/**
+ * Rasterization of a triangle : on every row, each edge function bounds the abscissas on one side.
+ */
+class Triangle::EdgeFunctions : public Scanline {
+	public:
+		EdgeFunctions(const Triangle& triangle) : triangle(triangle) {}
+
+		void spans(double y, vector<Span>& spans) {
+			spans.clear();
+
+			double begin = -INFINITY, end = INFINITY;
+
+			for (size_t i = 0; i < 3; i++) {
+				const Point& V = triangle.vertices[i];
+				double r = triangle.b[i] * (y - V.y);
+
+				if (triangle.a[i] > 0)
+					begin = max(begin, V.x - r / triangle.a[i]);
+				else if (triangle.a[i] < 0)
+					end = min(end, V.x - r / triangle.a[i]);
+				else if (r < 0)
+					return;
+			}
+
+			snap(begin, end, [&](double x) { return triangle.inside(Point(x, y)); }, spans);
+		}
+
+	private:
+		const Triangle& triangle;
+};
+
+unique_ptr<Scanline> Triangle::scanline() const {
+	// A flat triangle has no interior
+	if (flat)
+		return nullptr;
+
+	return make_unique<EdgeFunctions>(*this);
+}
+
+shape_ptr Triangle::scaled(double factor) const {
+	return make_shared<Triangle>(Triangle({vertices[0] * factor, vertices[1] * factor, vertices[2] * factor}));
+}
+
+shape_ptr Shift::create(const Point& P, const shape_ptr& shape) {
+	shape_ptr moved = shape->moved(1, 0, Point(), P);
 
-	return true;
+	return moved ? moved : make_shared<Shift>(Shift(P, shape));
+}
+
+shape_ptr Rotation::create(double cos_theta, double sin_theta, const Point& P, const shape_ptr& shape) {
+	shape_ptr moved = shape->moved(cos_theta, sin_theta, P, Point());
+
+	return moved ? moved : make_shared<Rotation>(Rotation(cos_theta, sin_theta, P, shape));
+}
+
+shape_ptr Scale::create(double factor, const shape_ptr& shape) {
+	shape_ptr scaled = shape->scaled(factor);
+
+	return scaled ? scaled : make_shared<Scale>(Scale(factor, shape));
+}
+
+shape_ptr Shift::scaled(double factor) const {
+	return Shift::create(center * factor, Scale::create(factor, shape));
+}
+
+shape_ptr Rotation::scaled(double factor) const {
+	return Rotation::create(cos_theta, sin_theta, center * factor, Scale::create(factor, shape));
 }
 
 Domain Shift::domain() const {
@@ -208,7 +541,15 @@ Domain Rotation::domain() const {
 	return Polygon(vertices).domain();
 }
 
+Domain Scale::domain() const {
+	Domain dom = shape->domain();
+
+	return {dom.min * factor, dom.max * factor};
+}
+
 bool Union::has(const Point& P) const {
+	count(UNION);
+
 	for (auto it = set.begin(); it != set.end(); it++)
 		if ((*it)->has(P))
 			return true;
@@ -216,6 +557,16 @@ bool Union::has(const Point& P) const {
 	return false;
 }
 
+double Union::distance(const Point& P) const {
+	double d = set[0]->distance(P);
+
+	// Within one of the shapes, its own bound is a bound of the union
+	for (auto it = set.begin() + 1; it != set.end() && d >= 0; it++)
+		d = min(d, (*it)->distance(P));
+
+	return d;
+}
+
 Domain Union::domain() const {
 	Domain dom = set[0]->domain(), temp;
 
@@ -236,4 +587,18 @@ Domain Union::domain() const {
 	}
 
 	return dom;
-}
\ No newline at end of file
+}
+
+shape_ptr Union::scaled(double factor) const {
+	vector<shape_ptr> scaled;
+	for (const shape_ptr& shape : set)
+		scaled.push_back(Scale::create(factor, shape));
+
+	return make_shared<Union>(Union(scaled));
+}
+
+shape_ptr Difference::scaled(double factor) const {
+	shape_ptr scaled_in = Scale::create(factor, in), scaled_out = Scale::create(factor, out);
+
+	return make_shared<Difference>(Difference(scaled_in, scaled_out));
+}
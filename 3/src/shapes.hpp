@@ -1,12 +1,16 @@
 #ifndef SHAPES_H
 #define SHAPES_H
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
+class SceneWriter;
+
 class NamedPointException: public std::exception {
 	public:
 		explicit NamedPointException(const std::string& message) : message(message) {};
@@ -44,6 +48,16 @@ class Point {
 		 */
 		static double cross(const Point& v1, const Point& v2) { return v1.x * v2.y - v2.x * v1.y; };
 
+		/**
+		 * @return the dot product between two vectors
+		 */
+		static double dot(const Point& v1, const Point& v2) { return v1.x * v2.x + v1.y * v2.y; };
+
+		/**
+		 * @return the norm of the vector
+		 */
+		double norm() const { return sqrt(x * x + y * y); };
+
 		bool operator ==(const Point& P) const { return x == P.x && y == P.y; };
 
 		Point operator +(const Point& P) const { return Point(x + P.x, y + P.y); };
@@ -59,6 +73,31 @@ class Point {
 
 struct Domain { Point min; Point max; };
 
+/**
+ * Interval [begin, end) of abscissas.
+ */
+struct Span { double begin; double end; };
+
+/**
+ * Row by row rasterization of a shape, the rows being visited by increasing ordinates.
+ */
+class Scanline {
+	public:
+		virtual ~Scanline() = default;
+
+		/**
+		 * Compute the abscissas of the points of the horizontal line of ordinate y which are within the shape.
+		 *
+		 * @param[out] spans the disjoint intervals of these abscissas, in increasing order
+		 */
+		virtual void spans(double y, std::vector<Span>& spans) = 0;
+};
+
+/**
+ * Types of shapes, as stored in compiled scenes and counted when profiling.
+ */
+enum ShapeType : uint32_t { ELLIPSE, CIRCLE, POLYGON, RECTANGLE, TRIANGLE, SHIFT, ROTATION, UNION, DIFFERENCE, SCALE, SHAPE_TYPES };
+
 class Shape {
 	public:
 		virtual ~Shape() = default;
@@ -76,6 +115,13 @@ class Shape {
 		 */
 		virtual bool has(const Point& P) const = 0;
 
+		/**
+		 * Bound the distance between P and the boundary of the shape : no point closer to P than |distance(P)| is on the boundary.
+		 *
+		 * @return a lower bound of the distance, negative if P is within the shape, 0 if unknown
+		 */
+		virtual double distance(const Point& P) const = 0;
+
 		/**
 		 * Compute the two opposite vertices of a rectangle that fully contains the shape.
 		 * 
@@ -83,9 +129,52 @@ class Shape {
 		 */
 		virtual Domain domain() const = 0;
 
+		/**
+		 * Append the shape, after the shapes it depends on, to a compiled scene.
+		 *
+		 * @return the index of the shape in the scene
+		 */
+		virtual uint32_t compile(SceneWriter& scene) const = 0;
+
+		/**
+		 * @return a rasterization of the shape by rows, or null if the shape has to be rasterized point by point with has()
+		 */
+		virtual std::unique_ptr<Scanline> scanline() const { return nullptr; };
+
+		/**
+		 * Move the shape itself, rather than through a Rotation or Shift of it, when it is then cheaper to test.
+		 *
+		 * @param cos_theta, sin_theta, P a rotation around P, followed by
+		 * @param shift a shift
+		 * @return the moved shape, or null if the shape has to be wrapped
+		 */
+		virtual std::shared_ptr<const Shape> moved(double, double, const Point&, const Point&) const { return nullptr; };
+
+		/**
+		 * Scale the shape itself, rather than through a Scale of it, such that it keeps its rasterization by rows.
+		 *
+		 * @param factor the scale factor, around origin
+		 * @return the scaled shape, or null if the shape has to be wrapped
+		 */
+		virtual std::shared_ptr<const Shape> scaled(double) const { return nullptr; };
+
+		/**
+		 * Whether the calls to has() are counted, per shape type, in calls.
+		 */
+		static bool profiling;
+		static uint64_t calls[SHAPE_TYPES];
+
 	protected:
 		Point center;
 
+		/**
+		 * Count a call to has() when profiling.
+		 */
+		static void count(ShapeType type) {
+			if (__builtin_expect(profiling, false))
+				calls[type]++;
+		};
+
 		/**
 		 * Tranform a point relative to the shape into an absolute point.
 		 */
@@ -101,52 +190,93 @@ typedef std::shared_ptr<const Shape> shape_ptr;
 
 class Ellipse : public Shape {
 	public:
-		Ellipse(Point center, double a, double b) : a(a), b(b), a2(pow(a, 2)) , b2(pow(b, 2)) {
-			assert(a >= 0);
-			assert(b >= 0);
-
-			this->center = center;
-		};
+		/**
+		 * @param cos_theta, sin_theta the orientation of the semi-major axis
+		 */
+		Ellipse(Point center, double a, double b, double cos_theta = 1, double sin_theta = 0);
 
 		virtual Point point(const std::string& name) const;
-		virtual bool has(const Point& P) const;
-		virtual Domain domain() const { return {this->absolute(Point(-a, -b)), this->absolute(Point(a, b))}; };
+		virtual bool has(const Point& P) const { count(ELLIPSE); return this->inside(P); };
+		virtual double distance(const Point& P) const;
+		virtual Domain domain() const;
+		virtual uint32_t compile(SceneWriter& scene) const;
+		virtual std::unique_ptr<Scanline> scanline() const;
+		virtual shape_ptr moved(double cos_theta, double sin_theta, const Point& P, const Point& shift) const;
+		virtual shape_ptr scaled(double factor) const;
 
 	protected:
 		double a, b, a2, b2;
+		double cos_theta, sin_theta;
+
+		/**
+		 * Quadratic form of the ellipse : P is within it if xx dx² + xy dx dy + yy dy² <= limit, where (dx, dy) = P - center.
+		 */
+		double xx, xy, yy, limit;
+
+		bool inside(const Point& P) const {
+			Point Q = P - center;
+			return Q.x * Q.x * xx + Q.x * Q.y * xy + Q.y * Q.y * yy <= limit;
+		};
+
+		Point absolute(const Point& P) const { return P.rotation(cos_theta, sin_theta) + center; };
+		Point relative(const Point& P) const { return (P - center).rotation(cos_theta, -sin_theta); };
+
+	private:
+		class Chords;
 };
 
 class Circle : public Ellipse {
 	public:
-		Circle(Point center, double radius) : Ellipse(center, radius, radius) {};
+		Circle(Point center, double radius, double cos_theta = 1, double sin_theta = 0);
 
 		Point point(const std::string& name) const;
-		bool has(const Point& P) const;
+		bool has(const Point& P) const { count(CIRCLE); return this->inside(P); };
+		double distance(const Point& P) const { return (P - center).norm() - a; };
+		Domain domain() const { return {center - Point(a, a), center + Point(a, a)}; };
+		uint32_t compile(SceneWriter& scene) const;
+		shape_ptr moved(double cos_theta, double sin_theta, const Point& P, const Point& shift) const;
+		shape_ptr scaled(double factor) const;
 };
 
 class Polygon : public Shape {
 	public:
-		Polygon(const std::vector<Point>& vertices);
+		/**
+		 * Rule deciding whether a point is within a polygon from the edges crossed by a ray from the point : an odd number of them (EVENODD), or edges not summing to zero when counted by direction (NONZERO).
+		 */
+		enum Rule : uint32_t { NONZERO, EVENODD };
 
-		virtual Point point(const std::string& name) const {
-			if (name == "c")
-				return center;
-			else
-				throw NamedPointException("invalid named point " + name);
-		};
-		virtual bool has(const Point& P) const { return center == P; };
+		Polygon(const std::vector<Point>& vertices, Rule rule = NONZERO);
+
+		virtual Point point(const std::string& name) const;
+		virtual bool has(const Point& P) const { count(POLYGON); return this->inside(P); };
+		virtual double distance(const Point& P) const;
 		virtual Domain domain() const;
+		virtual uint32_t compile(SceneWriter& scene) const;
+		virtual std::unique_ptr<Scanline> scanline() const;
+		virtual std::shared_ptr<const Shape> scaled(double factor) const;
 
 	protected:
 		unsigned n;
 		std::vector<Point> vertices;
+		Rule rule;
 
-		Polygon() {};
+		Polygon() : rule(NONZERO) {};
 
 		/**
 		 * @return the midpoint of the segment joining the ith and jth vertices of the polygon
 		 */
 		Point midpoint(size_t i, size_t j) const { return (vertices[i] + vertices[j]) / 2; };
+
+		/**
+		 * @return the distance between P and the segment joining the ith and jth vertices of the polygon
+		 */
+		double segment(const Point& P, size_t i, size_t j) const;
+
+	private:
+		/**
+		 * @return true if P is within the polygon according to its rule
+		 */
+		bool inside(const Point& P) const;
 };
 
 class Rectangle : public Polygon {
@@ -155,7 +285,11 @@ class Rectangle : public Polygon {
 
 		Point point(const std::string& name) const;
 		bool has(const Point& P) const;
+		double distance(const Point& P) const;
 		Domain domain() const { return {vertices[2], vertices[0]}; };
+		uint32_t compile(SceneWriter& scene) const;
+		std::unique_ptr<Scanline> scanline() const { return nullptr; };
+		std::shared_ptr<const Shape> scaled(double factor) const;
 
 	private:
 		double width, height;
@@ -163,19 +297,52 @@ class Rectangle : public Polygon {
 
 class Triangle : public Polygon {
 	public:
-		Triangle(const std::vector<Point>& vertices) : Polygon(vertices) {};
+		Triangle(const std::vector<Point>& vertices);
 
 		Point point(const std::string& name) const;
 		bool has(const Point& P) const;
+		double distance(const Point& P) const;
+		uint32_t compile(SceneWriter& scene) const;
+		std::unique_ptr<Scanline> scanline() const;
+		std::shared_ptr<const Shape> scaled(double factor) const;
+
+	private:
+		class EdgeFunctions;
+
+		/**
+		 * Edge functions : the ith one, a[i] (x - xi) + b[i] (y - yi) where (xi, yi) is the ith vertex, is null on the side from this vertex to the next, and non-negative within the triangle.
+		 * Being relative to a vertex, its rounding errors don't grow with the distance of the triangle to the origin.
+		 */
+		double a[3], b[3];
+
+		/**
+		 * Whether the vertices are aligned : the edge functions are then null on a whole line (or everywhere if the vertices coincide), and the triangle has no interior.
+		 */
+		bool flat;
+
+		double edge(size_t i, const Point& P) const { return a[i] * (P.x - vertices[i].x) + b[i] * (P.y - vertices[i].y); };
+
+		/**
+		 * @return true if P is within the triangle or on its sides, without branching on the edges
+		 */
+		bool inside(const Point& P) const { return std::min(std::min(this->edge(0, P), this->edge(1, P)), this->edge(2, P)) >= 0 && !flat; };
 };
 
 class Shift : public Shape {
 	public:
 		Shift(const Point& P, const shape_ptr& shape) : shape(shape) { center = P; };
 
+		/**
+		 * @return the shift of a shape, moved itself if it can be
+		 */
+		static shape_ptr create(const Point& P, const shape_ptr& shape);
+
 		Point point(const std::string& name) const { return this->absolute(shape->point(name)); };
-		bool has(const Point& P) const { return shape->has(this->relative(P)); };
+		bool has(const Point& P) const { count(SHIFT); return shape->has(this->relative(P)); };
+		double distance(const Point& P) const { return shape->distance(this->relative(P)); };
 		Domain domain() const;
+		uint32_t compile(SceneWriter& scene) const;
+		shape_ptr scaled(double factor) const;
 
 	private:
 		shape_ptr shape;
@@ -184,10 +351,19 @@ class Shift : public Shape {
 class Rotation : public Shape {
 	public:
 		Rotation(double theta, const Point& P, const shape_ptr& shape) : sin_theta(sin(theta)), cos_theta(cos(theta)), shape(shape) { center = P; };
+		Rotation(double cos_theta, double sin_theta, const Point& P, const shape_ptr& shape) : sin_theta(sin_theta), cos_theta(cos_theta), shape(shape) { center = P; };
+
+		/**
+		 * @return the rotation of a shape, moved itself if it can be
+		 */
+		static shape_ptr create(double cos_theta, double sin_theta, const Point& P, const shape_ptr& shape);
 
 		Point point(const std::string& name) const { return this->absolute(shape->point(name)); };
-		bool has(const Point& P) const { return shape->has(this->relative(P)); };
+		bool has(const Point& P) const { count(ROTATION); return shape->has(this->relative(P)); };
+		double distance(const Point& P) const { return shape->distance(this->relative(P)); };
 		Domain domain() const;
+		uint32_t compile(SceneWriter& scene) const;
+		shape_ptr scaled(double factor) const;
 
 	private:
 		double sin_theta, cos_theta;
@@ -197,13 +373,39 @@ class Rotation : public Shape {
 		Point relative(const Point& P) const { return P.rotation(cos_theta, -sin_theta, center); };
 };
 
+class Scale : public Shape {
+	public:
+		Scale(double factor, const shape_ptr& shape) : factor(factor), shape(shape) {
+			assert(factor > 0);
+		};
+
+		/**
+		 * @return the scale of a shape, scaled itself if it can be
+		 */
+		static shape_ptr create(double factor, const shape_ptr& shape);
+
+		Point point(const std::string& name) const { return shape->point(name) * factor; };
+		bool has(const Point& P) const { count(SCALE); return shape->has(P / factor); };
+		double distance(const Point& P) const { return shape->distance(P / factor) * factor; };
+		Domain domain() const;
+		uint32_t compile(SceneWriter& scene) const;
+		shape_ptr scaled(double factor) const { return Scale::create(this->factor * factor, shape); };
+
+	private:
+		double factor;
+		shape_ptr shape;
+};
+
 class Union : public Shape {
 	public:
 		Union(std::vector<shape_ptr>& set) : set(set) {}
 
 		Point point(const std::string& name) const { return this->absolute(set[0]->point(name)); };
 		bool has(const Point& P) const;
+		double distance(const Point& P) const;
 		Domain domain() const;
+		uint32_t compile(SceneWriter& scene) const;
+		shape_ptr scaled(double factor) const;
 
 	private:
 		std::vector<shape_ptr> set;
@@ -214,8 +416,11 @@ class Difference : public Shape {
 		Difference(shape_ptr& in, shape_ptr& out) : in(in), out(out) {};
 
 		Point point(const std::string& name) const { return this->absolute(in->point(name)); };
-		bool has(const Point& P) const { return in->has(P) && !out->has(P); };
+		bool has(const Point& P) const { count(DIFFERENCE); return in->has(P) && !out->has(P); };
+		double distance(const Point& P) const { return std::max(in->distance(P), -out->distance(P)); };
 		Domain domain() const { return in->domain(); }
+		uint32_t compile(SceneWriter& scene) const;
+		shape_ptr scaled(double factor) const;
 
 	private:
 		shape_ptr in, out;
@@ -0,0 +1,117 @@
+#include "cursor.hpp"
+
+#include <cctype>
+
+using namespace std;
+
+Cursor::Cursor() : input(nullptr), lin(0), lin_max(0), col(0), col_max(0), word(0) {}
+
+Cursor::Cursor(const vector<string>& input) : input(&input), lin(0), lin_max(input.size()), col(0), col_max(input.empty() ? 0 : input[0].length()), word(0) {}
+
+string Cursor::at() const {
+	return to_string(lin + 1) + ":" + to_string(col + 1 - word) + ":";
+}
+
+string Cursor::graphic() const {
+	const string& line = lin < lin_max ? (*input)[lin] : string();
+	return '\t' + line + '\n' + '\t' + string(col - word, ' ') + '^';
+}
+
+bool Cursor::skip() {
+	while (true) {
+		if (lin < lin_max) {
+			const string& line = (*input)[lin];
+
+			while (col < col_max && isspace(line[col]))
+				col++;
+
+			if (col < col_max && line[col] != '#')
+				return true;
+		}
+
+		if (lin + 1 >= lin_max)
+			return false;
+
+		col = 0;
+		col_max = (*input)[++lin].length();
+	}
+}
+
+char Cursor::nextChar() {
+	unsigned prev_lin = lin, prev_col = col;
+	char ch = this->skip() ? (*input)[lin][col] : ' ';
+
+	// The cursor only moves to the line of the next word
+	col = lin == prev_lin ? prev_col : 0;
+	word = 0;
+
+	return ch;
+}
+
+string Cursor::nextWord() {
+	if (!this->skip()) {
+		word = 0;
+		return string();
+	}
+
+	unsigned prev = col;
+
+	col = Cursor::end((*input)[lin], prev);
+	word = col - prev;
+
+	return (*input)[lin].substr(prev, word);
+}
+
+bool Cursor::resync(const function<bool(const string&)>& predicate) {
+	for (unsigned next = lin; next < lin_max; next++) {
+		const string& line = (*input)[next];
+
+		unsigned begin = 0;
+		while (begin < line.length() && isspace(line[begin]))
+			begin++;
+
+		if (begin == line.length() || line[begin] == '#')
+			continue;
+
+		// The first word of the current line may have been passed already, or be the word just read
+		if (next == lin && col - word > begin)
+			continue;
+
+		bool read = next == lin && col > begin;
+
+		// A word in the first column starts a new declaration, even if it fails the predicate
+		if ((begin == 0 && isalpha(line[0]) && !read) || predicate(line.substr(begin, Cursor::end(line, begin) - begin))) {
+			lin = next;
+			col = 0;
+			col_max = line.length();
+			word = 0;
+
+			return true;
+		}
+	}
+
+	// Move to the end of the input
+	if (lin_max > 0) {
+		lin = lin_max - 1;
+		col = col_max = (*input)[lin].length();
+	}
+
+	word = 0;
+
+	return false;
+}
+
+unsigned Cursor::end(const string& line, unsigned begin) {
+	unsigned col = begin + 1;
+
+	char ch = line[begin];
+	if (ch != ')' && ch != '}' && ch != '(' && ch != '{')
+		while (col < line.length()) {
+			ch = line[col];
+			if (isspace(ch) || ch == ')' || ch == '}' || ch == '(' || ch == '{' || ch == '#')
+				break;
+			col++;
+		}
+
+	return col;
+}
@@ -0,0 +1,66 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Tokenizer of .paint files, shared by painter-check and painter.
+ *
+ * @note the input isn't copied : it has to outlive the cursor.
+ */
+class Cursor {
+	public:
+		Cursor();
+		Cursor(const std::vector<std::string>& input);
+
+		/**
+		 * @return the current position formatted as LINE:COL:
+		 */
+		std::string at() const;
+
+		/**
+		 * @return the current position graphically
+		 */
+		std::string graphic() const;
+
+		/**
+		 * Move the cursor to the start of the next word.
+		 *
+		 * @return the first character of the next word
+		 */
+		char nextChar();
+
+		/**
+		 * Move the cursor to the end of the next word.
+		 *
+		 * @return the next word
+		 */
+		std::string nextWord();
+
+		/**
+		 * Move the cursor to the start of the next line whose first word satisfies a predicate, such as being a keyword, or starts in the first column with a letter, such that an unknown keyword is reported in turn. The current line is kept if its first word qualifies and hasn't been passed yet.
+		 *
+		 * @return false if there is no such line, true otherwise
+		 */
+		bool resync(const std::function<bool(const std::string&)>& predicate);
+
+	private:
+		const std::vector<std::string>* input;
+		unsigned lin, lin_max, col, col_max, word;
+
+		/**
+		 * Move the cursor to the start of the next word, skipping whitespaces, comments and empty lines.
+		 *
+		 * @return false if there is no next word, true otherwise
+		 */
+		bool skip();
+
+		/**
+		 * @return the position past the end of the word starting at a position of a line
+		 */
+		static unsigned end(const std::string& line, unsigned begin);
+};
+
+#endif
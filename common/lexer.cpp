@@ -0,0 +1,83 @@
+#include "lexer.hpp"
+
+#include <cctype>
+
+using namespace std;
+
+void lexer::name(const string& str) {
+	if (str.empty())
+		throw ParseException("expected name, got empty");
+
+	auto it = str.begin();
+	if (!isalpha(*it))
+		throw ParseException("invalid first character " + string(1, *it));
+
+	while (++it != str.end())
+		if (!isalnum(*it) && *it != '_')
+			throw ParseException("invalid character " + string(1, *it));
+}
+
+/**
+ * @return the FNV-1a hash of a string
+ */
+static size_t fnv(const char* str, size_t length) {
+	uint64_t h = 14695981039346656037ull;
+	for (size_t i = 0; i < length; i++)
+		h = (h ^ (unsigned char) str[i]) * 1099511628211ull;
+
+	return h;
+}
+
+Symbols::Symbols() : bounds(1, 0), slots(64, 0) {}
+
+size_t Symbols::slot(const string& name, size_t h) const {
+	size_t mask = slots.size() - 1;
+
+	for (size_t i = h & mask; ; i = (i + 1) & mask) {
+		uint32_t id = slots[i];
+
+		// Slots hold name indices plus one, 0 being empty
+		if (id == 0)
+			return i;
+
+		uint32_t begin = bounds[id - 1], length = bounds[id] - begin;
+
+		if (length == name.length() && pool.compare(begin, length, name) == 0)
+			return i;
+	}
+}
+
+bool Symbols::declare(const string& name) {
+	size_t i = this->slot(name, fnv(name.data(), name.length()));
+
+	if (slots[i] != 0)
+		return false;
+
+	pool.append(name);
+	bounds.push_back(pool.size());
+	slots[i] = this->size();
+
+	// Keep the load factor below one half
+	if (2 * this->size() > slots.size())
+		this->grow();
+
+	return true;
+}
+
+bool Symbols::contains(const string& name) const {
+	return slots[this->slot(name, fnv(name.data(), name.length()))] != 0;
+}
+
+void Symbols::grow() {
+	slots.assign(2 * slots.size(), 0);
+	size_t mask = slots.size() - 1;
+
+	for (uint32_t id = 1; id <= this->size(); id++) {
+		size_t i = fnv(pool.data() + bounds[id - 1], bounds[id] - bounds[id - 1]) & mask;
+
+		while (slots[i] != 0)
+			i = (i + 1) & mask;
+
+		slots[i] = id;
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+class ParseException: public std::exception {
+	public:
+		explicit ParseException(const std::string& message) : message(message) {};
+		virtual const char* what() const throw() { return message.c_str(); };
+
+	private:
+		std::string message;
+};
+
+/**
+ * Diagnostics of a recovering parse.
+ *
+ * @note at most limit messages are kept, such that memory is bounded however broken the input is. The others are only counted.
+ */
+class Diagnostics {
+	public:
+		explicit Diagnostics(size_t limit = 100) : limit(limit), total(0) {}
+
+		/**
+		 * Report a diagnostic.
+		 */
+		void report(const std::string& message) {
+			if (messages.size() < limit)
+				messages.push_back(message);
+			total++;
+		}
+
+		/**
+		 * @return the kept messages, in report order
+		 */
+		const std::vector<std::string>& kept() const { return messages; }
+
+		/**
+		 * @return the number of reported diagnostics
+		 */
+		size_t count() const { return total; }
+
+	private:
+		std::vector<std::string> messages;
+		size_t limit, total;
+};
+
+namespace lexer {
+	/**
+	 * Parse as a name the given string.
+	 *
+	 * @throw a ParseException if the given string isn't a valid name
+	 */
+	void name(const std::string& str);
+};
+
+/**
+ * Interned table of declared names, such that declarations and references are checked in constant time.
+ *
+ * @note names are stored once, contiguously, and hashed into an open-addressing table of name indices : a declaration costs no allocation of its own.
+ */
+class Symbols {
+	public:
+		Symbols();
+
+		/**
+		 * Declare a name.
+		 *
+		 * @return false if the name is already declared, true otherwise
+		 */
+		bool declare(const std::string& name);
+
+		/**
+		 * @return true if the name is declared, false otherwise
+		 */
+		bool contains(const std::string& name) const;
+
+		/**
+		 * @return the number of declared names
+		 */
+		size_t size() const { return bounds.size() - 1; }
+
+	private:
+		std::string pool;
+		std::vector<uint32_t> bounds;
+		std::vector<uint32_t> slots;
+
+		/**
+		 * @return the slot of a name, either holding it or empty
+		 */
+		size_t slot(const std::string& name, size_t hash) const;
+
+		/**
+		 * Double the number of slots and insert the names again.
+		 */
+		void grow();
+};
+
+#endif